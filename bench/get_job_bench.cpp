@@ -0,0 +1,119 @@
+/*
+  GetJob lookup cost vs. number of jobs on the queue.
+
+  Compares LinuxPrinter::GetJob (Get-Job-Attributes for one job) with the
+  old Get-Jobs download-and-scan over the queue's whole history. Jobs are
+  submitted held to a scratch queue created with lpadmin, so run it against
+  a scratch cupsd where you are allowed to add printers. cupsd refuses new
+  jobs past MaxJobs (500 by default), so the larger sizes need
+
+    MaxJobs 0
+
+  in its cupsd.conf; the bench stops with an error at the first size it
+  cannot reach.
+
+
+    g++ -std=c++17 -O2 -Isrc bench/get_job_bench.cpp src/linux_printer.cpp \
+        src/ppd_cache.cpp src/cups_connection_pool.cpp -lcups -o get_job_bench
+    ./get_job_bench 100 1000 10000
+*/
+
+#include "linux_printer.h"
+
+#include <cups/cups.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const int kIterations = 50;
+static const char *kQueue = "esslassi_bench_jobs";
+
+template <typename Fn>
+static double MicrosPerCall(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; i++)
+        fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / kIterations;
+}
+
+// The lookup GetJob used to do: every job on the queue, then a scan
+static bool ScanForJob(int jobId)
+{
+    cups_job_t *jobs = nullptr;
+    int num = cupsGetJobs2(CUPS_HTTP_DEFAULT, &jobs, kQueue, 0, CUPS_WHICHJOBS_ALL);
+
+    bool found = false;
+    for (int i = 0; i < num && !found; i++)
+        found = jobs[i].id == jobId;
+
+    cupsFreeJobs(num, jobs);
+    return found;
+}
+
+// Cancels the bench's jobs and deletes its queue
+static bool RemoveQueue()
+{
+    std::string cmd = "cancel -a -x " + std::string(kQueue) + " >/dev/null 2>&1";
+    bool ok = std::system(cmd.c_str()) == 0;
+    cmd = "lpadmin -x " + std::string(kQueue) + " >/dev/null 2>&1";
+    return std::system(cmd.c_str()) == 0 && ok;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty())
+        sizes = { 100, 1000, 10000 };
+
+    std::string cmd = "lpadmin -p " + std::string(kQueue) + " -E -v socket://127.0.0.1:9 >/dev/null 2>&1";
+    if (std::system(cmd.c_str()) != 0)
+    {
+        std::fprintf(stderr, "lpadmin failed\n");
+        return 1;
+    }
+
+    LinuxPrinter printer;
+    StringMap held = { { "job-hold-until", "indefinite" } };
+    const char payload[] = "bench\n";
+    ByteSpan data{ (const uint8_t *)payload, sizeof(payload) - 1 };
+
+    std::printf("%8s %16s %16s\n", "jobs", "single (us)", "get-jobs (us)");
+
+    int submitted = 0;
+    int target = 0;
+    for (int size : sizes)
+    {
+        for (; submitted < size; submitted++)
+        {
+            int id = printer.PrintDirect(kQueue, data, "RAW", held, PrintControl());
+            if (id <= 0)
+            {
+                std::fprintf(stderr, "submit failed after %d of %d jobs: %s\n",
+                             submitted, size, cupsLastErrorString());
+                RemoveQueue();
+                return 1;
+            }
+            if (!target)
+                target = id;
+        }
+
+        double single = MicrosPerCall([&]() { printer.GetJob(kQueue, target); });
+        double scan = MicrosPerCall([&]() { ScanForJob(target); });
+
+        std::printf("%8d %16.1f %16.1f\n", submitted, single, scan);
+    }
+
+    if (!RemoveQueue())
+    {
+        std::fprintf(stderr, "could not remove %s\n", kQueue);
+        return 1;
+    }
+    return 0;
+}
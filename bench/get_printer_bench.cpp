@@ -0,0 +1,91 @@
+/*
+  GetPrinter lookup cost vs. number of CUPS queues.
+
+  Compares LinuxPrinter::GetPrinter (single named-destination query) with
+  the old enumerate-and-scan lookup over GetPrinters(). Queues are created
+  with lpadmin, so run it against a scratch cupsd where you are allowed to
+  add printers:
+
+    g++ -std=c++17 -O2 -Isrc bench/get_printer_bench.cpp src/linux_printer.cpp \
+        src/ppd_cache.cpp src/cups_connection_pool.cpp -lcups -o get_printer_bench
+    ./get_printer_bench 10 100 300
+*/
+
+#include "linux_printer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+static const int kIterations = 200;
+static const char *kPrefix = "esslassi_bench_";
+
+static void CreateQueues(int from, int to)
+{
+    for (int i = from; i < to; i++)
+    {
+        std::string cmd = "lpadmin -p " + std::string(kPrefix) + std::to_string(i) +
+                          " -E -v socket://127.0.0.1:9 >/dev/null 2>&1";
+        if (std::system(cmd.c_str()) != 0)
+            std::fprintf(stderr, "lpadmin failed for queue %d\n", i);
+    }
+}
+
+static void DeleteQueues(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        std::string cmd = "lpadmin -x " + std::string(kPrefix) + std::to_string(i) + " >/dev/null 2>&1";
+        std::system(cmd.c_str());
+    }
+}
+
+template <typename Fn>
+static double MicrosPerCall(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIterations; i++)
+        fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::micro>(elapsed).count() / kIterations;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++)
+        sizes.push_back(std::atoi(argv[i]));
+    if (sizes.empty())
+        sizes = { 10, 100, 300 };
+
+    LinuxPrinter printer;
+    std::string target = std::string(kPrefix) + "0";
+
+    std::printf("%8s %16s %16s\n", "queues", "named (us)", "enum+scan (us)");
+
+    int created = 0;
+    for (int size : sizes)
+    {
+        if (size > created)
+        {
+            CreateQueues(created, size);
+            created = size;
+        }
+
+        double named = MicrosPerCall([&]() { printer.GetPrinter(target); });
+        double scan = MicrosPerCall([&]()
+        {
+            auto list = printer.GetPrinters();
+            for (auto &p : list)
+                if (p.name == target)
+                    break;
+        });
+
+        std::printf("%8d %16.1f %16.1f\n", created, named, scan);
+    }
+
+    DeleteQueues(created);
+    return 0;
+}
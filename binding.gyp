@@ -5,7 +5,14 @@
       "sources": [
         "src/main.cpp",
         "src/print.cpp",
-        "src/printer_factory.cpp"
+        "src/printer_factory.cpp",
+        "src/printer_registry.cpp",
+        "src/printer_service.cpp",
+        "src/print_executor.cpp",
+        "src/print_coalescer.cpp",
+        "src/print_retry.cpp",
+        "src/printer_watcher.cpp",
+        "src/job_poller.cpp"
       ],
       "include_dirs": [
         "<!@(node -p \"require('node-addon-api').include\")"
@@ -38,7 +45,11 @@
           }
         }],
         ['OS=="linux"', {
-          "sources": ["src/linux_printer.cpp"],
+          "sources": [
+            "src/linux_printer.cpp",
+            "src/ppd_cache.cpp",
+            "src/cups_connection_pool.cpp"
+          ],
           "libraries": ["-lcups"],
           "include_dirs": [
             "/usr/include/cups"
@@ -1,3 +1,4 @@
+import { Writable } from 'stream';
 import native from './native';
 
 /* ===========================
@@ -6,12 +7,46 @@ import native from './native';
 
 export type PrintOnSuccessFunction = (jobId: string) => any
 export type PrintOnErrorFunction = (err: Error) => any
+export type PrintOnProgressFunction = (bytesSent: number, totalBytes: number) => any
+
+/**
+ * What happens when a print queue limit is hit: 'reject' fails the job
+ * with an Error whose code is 'EQUEUEFULL', 'wait' holds it until
+ * earlier jobs finish.
+ */
+export type QueueFullPolicy = 'reject' | 'wait'
+
+export type PrintType =
+  | 'RAW'
+  | 'TEXT'
+  | 'COMMAND'
+  | 'AUTO'
+  | 'PDF'
+  | 'JPEG'
+  | 'POSTSCRIPT'
 
 export interface PrintDirectOptions {
   data: string | Buffer
   printer?: string
-  type?: 'RAW' | 'TEXT' | 'COMMAND' | 'AUTO'
+  type?: PrintType
   options?: { [key: string]: string }
+  /** Throttled upload progress; chunks the upload on every platform */
+  onProgress?: PrintOnProgressFunction
+  queueFull?: QueueFullPolicy
+  /** 1 (bulk) .. 100 (urgent), default 50 */
+  priority?: number
+  /** Milliseconds from now; a job not started by then fails with ETIMEDOUT */
+  deadline?: number
+  /** Drops a queued job, or stops its upload and cancels it; fails with AbortError */
+  signal?: AbortSignal
+  /** Overrides setPrinterTimeouts for this job */
+  timeout?: PrinterTimeouts
+  /** Overrides the retry count of setPrintRetryPolicy for this job */
+  retries?: number
+  /** Dedupes across retries and calls: resubmitting with the same key returns the job already submitted (Linux) */
+  idempotencyKey?: string
+  /** false keeps this job out of coalescing (see setPrintCoalescing) */
+  coalesce?: boolean
   success?: PrintOnSuccessFunction
   error?: PrintOnErrorFunction
 }
@@ -19,10 +54,56 @@ export interface PrintDirectOptions {
 export interface PrintFileOptions {
   filename: string
   printer?: string
+  onProgress?: PrintOnProgressFunction
+  queueFull?: QueueFullPolicy
+  /** 1 (bulk) .. 100 (urgent), default 50 */
+  priority?: number
+  /** Milliseconds from now; a job not started by then fails with ETIMEDOUT */
+  deadline?: number
+  /** Drops a queued job, or stops its upload and cancels it; fails with AbortError */
+  signal?: AbortSignal
+  /** Overrides setPrinterTimeouts for this job */
+  timeout?: PrinterTimeouts
+  /** Overrides the retry count of setPrintRetryPolicy for this job */
+  retries?: number
+  /** Dedupes across retries and calls: resubmitting with the same key returns the job already submitted (Linux) */
+  idempotencyKey?: string
   success?: PrintOnSuccessFunction
   error?: PrintOnErrorFunction
 }
 
+export interface BatchDocument {
+  data: string | Buffer
+  type?: PrintType
+  name?: string
+}
+
+export interface BatchDocumentStatus {
+  index: number
+  ok: boolean
+  error?: string
+}
+
+export interface PrintBatchResult {
+  jobId: string
+  documents: BatchDocumentStatus[]
+}
+
+export interface PrintBatchOptions {
+  documents: BatchDocument[]
+  printer?: string
+  options?: { [key: string]: string }
+  queueFull?: QueueFullPolicy
+  success?: (result: PrintBatchResult) => any
+  error?: PrintOnErrorFunction
+}
+
+export interface PrintStreamOptions {
+  printer?: string
+  type?: PrintType
+  options?: { [key: string]: string }
+}
+
 export interface PrinterDetails {
   name: string
   isDefault: boolean
@@ -33,6 +114,102 @@ export interface PrinterDriverOptions {
   [key: string]: { [key: string]: boolean }
 }
 
+export type PrinterSnapshotField = 'details' | 'driverOptions' | 'paperSize'
+
+export interface PrinterSnapshotOptions {
+  fields?: PrinterSnapshotField[]
+}
+
+export interface PrinterSnapshot {
+  name: string
+  details?: PrinterDetails
+  driverOptions?: PrinterDriverOptions
+  paperSize?: string
+}
+
+export interface CapabilityCacheStats {
+  hits: number
+  misses: number
+  evictions: number
+  entries: number
+  bytes: number
+  maxEntries: number
+  maxBytes: number
+}
+
+export interface CapabilityCacheLimits {
+  maxEntries?: number
+  maxBytes?: number
+}
+
+/** 0 = unlimited. Bytes are payload memory held by queued and running jobs. */
+export interface PrintQueueLimits {
+  maxJobs?: number
+  maxBytes?: number
+  maxJobsPerPrinter?: number
+  maxBytesPerPrinter?: number
+}
+
+export interface PrintQueueDepth {
+  jobs: number
+  bytes: number
+  waiting: number
+}
+
+/**
+ * Milliseconds; 0 = default. connect bounds opening a connection, read
+ * each wait for the server, total the whole call. A call that runs out
+ * fails with code 'ETIMEDOUT' and `timeout` set to the limit's name.
+ */
+export interface PrinterTimeouts {
+  connectMs?: number
+  readMs?: number
+  totalMs?: number
+}
+
+/** Retries of print jobs that failed for a transient reason */
+export interface PrintRetryPolicy {
+  /** Attempts after the first (default 2) */
+  retries?: number
+  /** Delay before the first retry, doubled for each one after (default 250) */
+  baseDelayMs?: number
+  /** Upper bound on a single delay (default 4000) */
+  maxDelayMs?: number
+  /** 0..1, fraction of each delay taken off at random (default 0.5) */
+  jitter?: number
+}
+
+export interface PrintCoalescingOptions {
+  enabled?: boolean
+  /** How long a batch stays open for more jobs (default 10) */
+  windowMs?: number
+  /** Jobs per batch (default 32) */
+  maxJobs?: number
+  /** Payload per batch (default 64 KiB) */
+  maxBytes?: number
+  /** Larger jobs print on their own (default 4096) */
+  maxDocumentBytes?: number
+}
+
+/** Submit-to-start time of jobs that have started */
+export interface PrintQueueWaitLatency {
+  count: number
+  meanMs: number
+  maxMs: number
+}
+
+export interface PrintQueueStats extends PrintQueueDepth {
+  running: number
+  rejected: number
+  expired: number
+  cancelled: number
+  limits: Required<PrintQueueLimits>
+  /** Keyed by printer name; '' is the default printer */
+  printers: { [printerName: string]: PrintQueueDepth }
+  /** Keyed by job priority */
+  waitLatency: { [priority: string]: PrintQueueWaitLatency }
+}
+
 export type JobStatus =
   | 'PAUSED'
   | 'PRINTING'
@@ -40,6 +217,8 @@ export type JobStatus =
   | 'CANCELLED'
   | 'PENDING'
   | 'ABORTED'
+  /** Held up by the printer (paused, out of paper, error); not final */
+  | 'STOPPED'
 
 export type JobCommand =
   | "CANCEL"
@@ -60,6 +239,96 @@ export interface JobDetails {
   processingTime: Date
 }
 
+export type JobAttribute = 'name' | 'user' | 'format' | 'priority' | 'size' | 'times'
+
+export interface GetJobsOptions {
+  /** Default 'active' */
+  which?: 'active' | 'completed' | 'all'
+  limit?: number
+  /** Only jobs with this id or above; page with the last id + 1 */
+  firstJobId?: number
+  user?: string
+  /** Fields to fetch besides id, printerName and status (default all) */
+  attributes?: JobAttribute[]
+  /** Parallel arrays instead of one object per job */
+  columnar?: boolean
+}
+
+/** A listed job: only the requested attributes are present */
+export type ListedJob = Pick<JobDetails, 'id' | 'printerName' | 'status'> & Partial<JobDetails>
+
+/**
+ * A job list as parallel columns. `states[i]` and `printers[i]` index
+ * `stateNames` / `printerNames` (first status of each job); times are ms
+ * since the epoch, 0 when unset. Optional columns follow `attributes`.
+ */
+export interface JobColumns {
+  count: number
+  ids: Int32Array
+  states: Uint8Array
+  stateNames: JobStatus[]
+  printers: Uint16Array
+  printerNames: string[]
+  names?: string[]
+  users?: string[]
+  formats?: string[]
+  priorities?: Int32Array
+  sizes?: Int32Array
+  creationTimes?: Float64Array
+  processingTimes?: Float64Array
+  completedTimes?: Float64Array
+}
+
+/** IPP event keywords; the state-changed ones include the specific events */
+export type PrinterEventName =
+  | 'job-created'
+  | 'job-completed'
+  | 'job-stopped'
+  | 'job-state-changed'
+  | 'job-progress'
+  | 'printer-added'
+  | 'printer-deleted'
+  | 'printer-modified'
+  | 'printer-stopped'
+  | 'printer-restarted'
+  | 'printer-shutdown'
+  | 'printer-state-changed'
+
+export interface WatchOptions {
+  /** Default: every printer */
+  printers?: string[]
+  /** Default: ['job-state-changed', 'printer-state-changed'] */
+  events?: PrinterEventName[]
+  /** The subscription failed or was lost; it is retried */
+  onError?: (err: Error) => void
+}
+
+export interface PrinterEvent {
+  event: PrinterEventName
+  printerName: string
+  /** Job events only */
+  jobId?: number
+  /** JobStatus for job events; 'IDLE' | 'PROCESSING' | 'STOPPED' for printers */
+  status: string[]
+  message: string
+  time: Date
+}
+
+/** What watchJob reports each time the job's status changes */
+export type JobUpdate = Pick<JobDetails, 'id' | 'printerName' | 'status' | 'creationTime' | 'processingTime' | 'completedTime'>
+
+export interface WaitForJobOptions {
+  /** Resolve once the status contains one of these; default PRINTED, CANCELLED, ABORTED */
+  states?: JobStatus[]
+  /** Reject with code ETIMEDOUT after this long; default none */
+  timeoutMs?: number
+}
+
+export type WaitedJob = JobUpdate & {
+  /** From the job's creation to the state being reached (whole seconds) */
+  totalTimeMs?: number
+}
+
 /* ===========================
    DIRECT NATIVE EXPORTS
 =========================== */
@@ -82,10 +351,25 @@ export function getSelectedPaperSize(printerName: string): string {
   return native.getSelectedPaperSize(printerName)
 }
 
+export function getPrinterSnapshot(
+  printerName: string,
+  options?: PrinterSnapshotOptions
+): PrinterSnapshot {
+  return native.getPrinterSnapshot(printerName, options)
+}
+
 export function getDefaultPrinterName(): string | undefined {
   return native.getDefaultPrinterName()
 }
 
+export function refreshPrinters(): void {
+  native.refreshPrinters()
+}
+
+export function setPrinterRegistryTtl(ttlMs: number): void {
+  native.setPrinterRegistryTtl(ttlMs)
+}
+
 export function printDirect(options: PrintDirectOptions): void {
   native.printDirect(options)
 }
@@ -94,6 +378,83 @@ export function printFile(options: PrintFileOptions): void {
   native.printFile(options)
 }
 
+/**
+ * Worker threads for print submissions (default 2). Jobs for one printer
+ * run one at a time by priority, then submission order; different
+ * printers run in parallel.
+ */
+export function setPrintExecutorThreads(threads: number): void {
+  native.setPrintExecutorThreads(threads)
+}
+
+export function setPrintQueueLimits(limits: PrintQueueLimits): void {
+  native.setPrintQueueLimits(limits)
+}
+
+export function getPrintQueueStats(): PrintQueueStats {
+  return native.getPrintQueueStats()
+}
+
+/**
+ * Default timeouts for every CUPS call (Linux); merged with the current
+ * settings.
+ */
+export function setPrinterTimeouts(timeouts: PrinterTimeouts): void {
+  native.setPrinterTimeouts(timeouts)
+}
+
+/**
+ * Default retry policy for printDirect / printFile; merged with the
+ * current settings. A job that still fails transiently after its retries
+ * fails with code 'EAGAIN'.
+ */
+export function setPrintRetryPolicy(policy: PrintRetryPolicy): void {
+  native.setPrintRetryPolicy(policy)
+}
+
+/**
+ * Merges small RAW printDirect jobs to the same printer, arriving within
+ * `windowMs` of each other, into one job. Off by default; an object
+ * enables it unless `enabled: false`.
+ */
+export function setPrintCoalescing(options: boolean | PrintCoalescingOptions): void {
+  native.setPrintCoalescing(options)
+}
+
+/**
+ * Sends every document as part of one job (one Create-Job on CUPS).
+ */
+export function printBatch(options: PrintBatchOptions): void {
+  native.printBatch(options)
+}
+
+/**
+ * Writable that uploads each chunk to the printer as it arrives.
+ * Emits 'job' with the job id once the document is complete.
+ */
+export function createPrintStream(options: PrintStreamOptions = {}): Writable {
+  const handle = native.openPrintStream(options)
+
+  const stream: Writable = new Writable({
+    write(chunk: Buffer, _encoding, callback) {
+      handle.write(chunk, (err: Error | null) => callback(err))
+    },
+    final(callback) {
+      handle.end((err: Error | null, jobId: string) => {
+        if (!err) stream.emit('job', jobId)
+        callback(err)
+      })
+    },
+    destroy(err, callback) {
+      // No-op natively once the document has been finished
+      handle.abort()
+      callback(err)
+    }
+  })
+
+  return stream
+}
+
 export function getSupportedPrintFormats(): string[] {
   return native.getSupportedPrintFormats()
 }
@@ -105,6 +466,45 @@ export function getJob(
   return native.getJob(printerName, jobId)
 }
 
+/** Jobs in ascending id order; '' lists every printer */
+export function getJobs(printerName: string, options: GetJobsOptions & { columnar: true }): JobColumns
+export function getJobs(printerName: string, options?: GetJobsOptions): ListedJob[]
+export function getJobs(printerName: string, options?: GetJobsOptions): ListedJob[] | JobColumns {
+  return native.getJobs(printerName, options)
+}
+
+/**
+ * Pushes job and printer events to `callback` from one server-side
+ * subscription shared by every watcher (Linux / CUPS; throws ENOTSUP
+ * elsewhere). Returns the function that unsubscribes; an active watch
+ * keeps the process alive.
+ */
+export function watch(options: WatchOptions, callback: (event: PrinterEvent) => void): () => void {
+  return native.watch(options, callback)
+}
+
+/**
+ * Calls `callback` with the job's first known status and then on every
+ * change. All watched jobs share one poller that lists each printer's
+ * active jobs once per tick, faster while jobs are active (any platform). A
+ * job the printer does not have ends the watch.
+ * Returns the function that unsubscribes.
+ */
+export function watchJob(printerName: string, jobId: number, callback: (job: JobUpdate) => void): () => void {
+  return native.watchJob(printerName, jobId, callback)
+}
+
+/**
+ * Resolves as soon as the job reaches one of `options.states`, from the
+ * shared job poller or, where the backend has one, the event
+ * subscription; nothing is polled from JS. Rejects with code 'ENOENT'
+ * when the printer has no such job, and 'EJOBFINISHED' when it finished
+ * in a state not asked for.
+ */
+export function waitForJob(printerName: string, jobId: number, options?: WaitForJobOptions): Promise<WaitedJob> {
+  return native.waitForJob(printerName, jobId, options)
+}
+
 export function setJob(
   printerName: string,
   jobId: number,
@@ -116,6 +516,14 @@ export function setJob(
 export function getSupportedJobCommands(): string[] {
   return native.getSupportedJobCommands()
 }
+
+export function getCapabilityCacheStats(): CapabilityCacheStats {
+  return native.getCapabilityCacheStats()
+}
+
+export function setCapabilityCacheLimits(limits: CapabilityCacheLimits): void {
+  native.setCapabilityCacheLimits(limits)
+}
 /* ==================================================
    PROMISE WRAPPERS (Async/Await Friendly)
 ================================================== */
@@ -132,6 +540,18 @@ export function printDirectAsync(
   })
 }
 
+export function printBatchAsync(
+  options: Omit<PrintBatchOptions, 'success' | 'error'>
+): Promise<PrintBatchResult> {
+  return new Promise((resolve, reject) => {
+    native.printBatch({
+      ...options,
+      success: (result: PrintBatchResult) => resolve(result),
+      error: (err: Error) => reject(err)
+    })
+  })
+}
+
 export function printFileAsync(
   options: Omit<PrintFileOptions, 'success' | 'error'>
 ): Promise<string> {
@@ -148,15 +568,52 @@ export function getJobAsync(
   printerName: string,
   jobId: number
 ): Promise<JobDetails> {
-  return Promise.resolve(native.getJob(printerName, jobId))
+  return native.getJobAsync(printerName, jobId)
+}
+
+export function getJobsAsync(printerName: string, options: GetJobsOptions & { columnar: true }): Promise<JobColumns>
+export function getJobsAsync(printerName: string, options?: GetJobsOptions): Promise<ListedJob[]>
+export function getJobsAsync(printerName: string, options?: GetJobsOptions): Promise<ListedJob[] | JobColumns> {
+  return native.getJobsAsync(printerName, options)
+}
+
+export function setJobAsync(
+  printerName: string,
+  jobId: number,
+  command: JobCommand
+): Promise<void> {
+  return native.setJobAsync(printerName, jobId, command)
 }
 
 export function getPrintersAsync(): Promise<PrinterDetails[]> {
-  return Promise.resolve(native.getPrinters())
+  return native.getPrintersAsync()
 }
 
 export function getPrinterAsync(
   printerName: string
 ): Promise<PrinterDetails> {
-  return Promise.resolve(native.getPrinter(printerName))
+  return native.getPrinterAsync(printerName)
+}
+
+export function getDefaultPrinterNameAsync(): Promise<string | undefined> {
+  return native.getDefaultPrinterNameAsync()
+}
+
+export function getPrinterDriverOptionsAsync(
+  printerName: string
+): Promise<PrinterDriverOptions> {
+  return native.getPrinterDriverOptionsAsync(printerName)
+}
+
+export function getSelectedPaperSizeAsync(
+  printerName: string
+): Promise<string> {
+  return native.getSelectedPaperSizeAsync(printerName)
+}
+
+export function getPrinterSnapshotAsync(
+  printerName: string,
+  options?: PrinterSnapshotOptions
+): Promise<PrinterSnapshot> {
+  return native.getPrinterSnapshotAsync(printerName, options)
 }
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "cups_connection_pool.h"
+
+#include <cups/cups.h>
+
+#include <algorithm>
+#include <cerrno>
+
+#include <sys/socket.h>
+
+// How long a lease waits for a pooled connection before going overflow
+static const std::chrono::milliseconds kAcquireWait(2000);
+
+// cupsd closes keep-alive connections after KeepAliveTimeout (30 s by
+// default); anything idle longer is reconnected before use.
+static const std::chrono::seconds kIdleReconnect(20);
+
+// Used when no connect timeout is configured
+static const int kConnectTimeoutMs = 30000;
+
+using Clock = std::chrono::steady_clock;
+
+// Bounds each socket wait on http by the read timeout and what is left of
+// the call's deadline; neither set restores the libcups default.
+static void ApplyTimeouts(http_t *http, uint32_t readMs, Clock::time_point deadline)
+{
+    double seconds = readMs / 1000.0;
+    if (deadline != Clock::time_point::max())
+    {
+        double left = std::max(std::chrono::duration<double>(deadline - Clock::now()).count(), 0.001);
+        seconds = seconds > 0 ? std::min(seconds, left) : left;
+    }
+    httpSetTimeout(http, seconds, NULL, NULL);
+}
+
+/* =========================================================
+   Lease
+========================================================= */
+
+CupsConnectionPool::Lease::Lease(Lease &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+CupsConnectionPool::Lease &CupsConnectionPool::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        pool = other.pool;
+        server = other.server;
+        http = other.http;
+        broken = other.broken;
+        unpooled = other.unpooled;
+        readMs = other.readMs;
+        deadline = other.deadline;
+        other.pool = nullptr;
+        other.server = nullptr;
+        other.http = nullptr;
+        other.deadline = std::chrono::steady_clock::time_point::max();
+    }
+    return *this;
+}
+
+CupsConnectionPool::Lease::~Lease()
+{
+    Release();
+}
+
+void CupsConnectionPool::Lease::Rearm()
+{
+    if (http)
+        ApplyTimeouts(http, readMs, deadline);
+}
+
+void CupsConnectionPool::Lease::Release()
+{
+    if (!http)
+        return;
+
+    // A wait that ran out leaves the request half done.
+    if (httpError(http) == ETIMEDOUT)
+    {
+        LastTimeout() = Expired() ? TimeoutKind::Total : TimeoutKind::Read;
+        broken = true;
+    }
+    else if (broken && Expired())
+    {
+        LastTimeout() = TimeoutKind::Total;
+    }
+
+    if (unpooled)
+        httpClose(http);
+    else
+        pool->Return(server, http, broken);
+
+    http = nullptr;
+}
+
+/* =========================================================
+   Pool
+========================================================= */
+
+CupsConnectionPool::~CupsConnectionPool()
+{
+    CloseIdle();
+}
+
+CupsConnectionPool::Server &CupsConnectionPool::ServerFor(const std::string &host,
+                                                          int port,
+                                                          http_encryption_t encryption)
+{
+    std::string key = host + ":" + std::to_string(port) + ":" + std::to_string((int)encryption);
+
+    std::lock_guard<std::mutex> lock(mu);
+    auto &server = servers[key];
+    if (!server)
+    {
+        server.reset(new Server());
+        server->host = host;
+        server->port = port;
+        server->encryption = encryption;
+    }
+    return *server;
+}
+
+http_t *CupsConnectionPool::Connect(const Server &server, int timeoutMs)
+{
+    auto start = Clock::now();
+    http_t *http = httpConnect2(server.host.c_str(), server.port, NULL, AF_UNSPEC,
+                                server.encryption, 1, timeoutMs, NULL);
+
+    if (!http && Clock::now() - start >= std::chrono::milliseconds(timeoutMs))
+        LastTimeout() = TimeoutKind::Connect;
+    return http;
+}
+
+// Health check for an idle connection: true if it is usable (possibly
+// after reconnecting), false if it had to be given up.
+bool CupsConnectionPool::Revive(http_t *http, std::chrono::steady_clock::time_point since, int timeoutMs)
+{
+    bool stale = std::chrono::steady_clock::now() - since >= kIdleReconnect;
+
+    // An idle keep-alive socket that is readable has been closed (or
+    // poisoned) by the server.
+    if (!stale && httpError(http) == 0 && !httpWait(http, 0))
+        return true;
+
+    return httpReconnect2(http, timeoutMs, NULL) == 0;
+}
+
+// An empty lease on the default server with the call's timeouts applied
+CupsConnectionPool::Lease CupsConnectionPool::NewLease(const CallTimeouts &call, int &connectMs)
+{
+    CallTimeouts t = GetTimeouts();
+    if (call.connectMs)
+        t.connectMs = call.connectMs;
+    if (call.readMs)
+        t.readMs = call.readMs;
+    if (call.totalMs)
+        t.totalMs = call.totalMs;
+
+    Lease lease;
+    lease.pool = this;
+    lease.server = &ServerFor(cupsServer(), ippPort(), cupsEncryption());
+    lease.readMs = t.readMs;
+
+    connectMs = t.connectMs ? (int)t.connectMs : kConnectTimeoutMs;
+    if (t.totalMs)
+    {
+        lease.deadline = Clock::now() + std::chrono::milliseconds(t.totalMs);
+        connectMs = std::min(connectMs, (int)t.totalMs);
+    }
+    return lease;
+}
+
+CupsConnectionPool::Lease CupsConnectionPool::AcquireDedicated(const CallTimeouts &call)
+{
+    int connectMs;
+    Lease lease = NewLease(call, connectMs);
+
+    lease.unpooled = true;
+    lease.http = Connect(*lease.server, connectMs);
+    if (lease.http)
+        lease.Rearm();
+    return lease;
+}
+
+CupsConnectionPool::Lease CupsConnectionPool::Acquire(const CallTimeouts &call)
+{
+    int connectMs;
+    Lease lease = NewLease(call, connectMs);
+    Server &server = *lease.server;
+    auto now = Clock::now();
+
+    std::unique_lock<std::mutex> lock(server.mu);
+    auto waitUntil = std::min(now + kAcquireWait, lease.deadline);
+
+    for (;;)
+    {
+        if (!server.idle.empty())
+        {
+            Idle conn = server.idle.back();
+            server.idle.pop_back();
+            lock.unlock();
+
+            if (Revive(conn.http, conn.since, connectMs))
+            {
+                lease.http = conn.http;
+                lease.Rearm();
+                return lease;
+            }
+
+            httpClose(conn.http);
+            lock.lock();
+            server.open--;
+            continue;
+        }
+
+        if (server.open < maxPerServer)
+        {
+            server.open++;
+            lock.unlock();
+
+            lease.http = Connect(server, connectMs);
+            if (!lease.http)
+            {
+                lock.lock();
+                server.open--;
+                server.cv.notify_one();
+                return lease;
+            }
+            lease.Rearm();
+            return lease;
+        }
+
+        if (server.cv.wait_until(lock, waitUntil) == std::cv_status::timeout)
+        {
+            lock.unlock();
+            if (lease.Expired())
+            {
+                LastTimeout() = TimeoutKind::Total;
+                return lease;
+            }
+
+            lease.http = Connect(server, connectMs);
+            lease.unpooled = true;
+            if (lease.http)
+                lease.Rearm();
+            return lease;
+        }
+    }
+}
+
+void CupsConnectionPool::Return(Server *server, http_t *http, bool broken)
+{
+    if (broken || httpError(http) != 0)
+    {
+        httpClose(http);
+        std::lock_guard<std::mutex> lock(server->mu);
+        server->open--;
+        server->cv.notify_one();
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(server->mu);
+    server->idle.push_back(Idle{ http, std::chrono::steady_clock::now() });
+    server->cv.notify_one();
+}
+
+void CupsConnectionPool::SetMaxPerServer(size_t max)
+{
+    maxPerServer = max > 0 ? max : 1;
+}
+
+void CupsConnectionPool::SetTimeouts(const CallTimeouts &newTimeouts)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    timeouts = newTimeouts;
+}
+
+CallTimeouts CupsConnectionPool::GetTimeouts()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return timeouts;
+}
+
+void CupsConnectionPool::CloseIdle()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    for (auto &kv : servers)
+    {
+        Server &server = *kv.second;
+        std::lock_guard<std::mutex> serverLock(server.mu);
+        for (auto &conn : server.idle)
+            httpClose(conn.http);
+        server.open -= server.idle.size();
+        server.idle.clear();
+    }
+}
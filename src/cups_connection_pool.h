@@ -0,0 +1,132 @@
+#ifndef CUPS_CONNECTION_POOL_H
+#define CUPS_CONNECTION_POOL_H
+
+#include "printer_interface.h"
+
+#include <cups/http.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+  Keep-alive HTTP connections to the CUPS server, shared by every call on
+  one backend instead of the thread-local CUPS_HTTP_DEFAULT.
+
+  Each server (host, port, encryption) gets up to maxPerServer pooled
+  connections. A lease gives one thread exclusive use of a connection;
+  idle connections are health-checked and reconnected before reuse. When
+  every pooled connection stays busy past a short wait, the lease gets a
+  one-off overflow connection instead of blocking (a thread holding a
+  lease may need a second one, e.g. to cancel its own job). Long-lived
+  users (event subscriptions, print streams) take a dedicated connection
+  instead, so they never hold one of the pooled slots.
+
+  Every lease carries the call's timeouts: connect bounds opening a
+  connection, read bounds each wait on the socket, and total sets a
+  deadline. Socket waits are bounded by what is left of the deadline
+  when the lease was last armed (Acquire, then Rearm before each step of
+  a multi-step call), and upload loops check it between chunks. A lease
+  that gives up on a timeout records it in LastTimeout() when it is
+  released.
+*/
+class CupsConnectionPool
+{
+    struct Server;
+
+public:
+    class Lease
+    {
+    public:
+        Lease() = default;
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        ~Lease();
+
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        http_t *get() const { return http; }
+        explicit operator bool() const { return http != nullptr; }
+
+        // The connection is in an unknown state (e.g. a failed upload):
+        // close it instead of returning it to the pool.
+        void MarkBroken() { broken = true; }
+
+        // The call's total timeout has passed
+        bool Expired() const { return std::chrono::steady_clock::now() >= deadline; }
+
+        // Bounds the socket waits of the next blocking step by the read
+        // timeout and what is left of the deadline
+        void Rearm();
+
+    private:
+        friend class CupsConnectionPool;
+
+        void Release();
+
+        CupsConnectionPool *pool = nullptr;
+        Server *server = nullptr;
+        http_t *http = nullptr;
+        bool broken = false;
+        bool unpooled = false; // overflow or dedicated: closed on release
+        uint32_t readMs = 0;
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    };
+
+    CupsConnectionPool() = default;
+    ~CupsConnectionPool();
+
+    CupsConnectionPool(const CupsConnectionPool &) = delete;
+    CupsConnectionPool &operator=(const CupsConnectionPool &) = delete;
+
+    // Connection to the default CUPS server; empty lease if it is
+    // unreachable. Non-zero fields of `call` override the pool's timeouts.
+    Lease Acquire(const CallTimeouts &call = CallTimeouts());
+
+    // A connection of its own, outside the pooled slots and closed when
+    // the lease is released; for leases held for minutes.
+    Lease AcquireDedicated(const CallTimeouts &call = CallTimeouts());
+
+    void SetMaxPerServer(size_t max);
+    void SetTimeouts(const CallTimeouts &timeouts);
+    CallTimeouts GetTimeouts();
+    void CloseIdle();
+
+private:
+    struct Idle
+    {
+        http_t *http;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    struct Server
+    {
+        std::string host;
+        int port = 0;
+        http_encryption_t encryption = HTTP_ENCRYPTION_IF_REQUESTED;
+
+        std::mutex mu;
+        std::condition_variable cv;
+        std::vector<Idle> idle;
+        size_t open = 0; // pooled connections, idle or leased
+    };
+
+    Lease NewLease(const CallTimeouts &call, int &connectMs);
+    Server &ServerFor(const std::string &host, int port, http_encryption_t encryption);
+    http_t *Connect(const Server &server, int timeoutMs);
+    bool Revive(http_t *http, std::chrono::steady_clock::time_point since, int timeoutMs);
+    void Return(Server *server, http_t *http, bool broken);
+
+    std::mutex mu;
+    std::map<std::string, std::unique_ptr<Server>> servers;
+    std::atomic<size_t> maxPerServer{4};
+    CallTimeouts timeouts; // guarded by mu
+};
+
+#endif
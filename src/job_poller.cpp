@@ -0,0 +1,225 @@
+#include "job_poller.h"
+#include "printer_service.h"
+
+#include <algorithm>
+#include <set>
+
+constexpr std::chrono::milliseconds JobPoller::kMinInterval;
+constexpr std::chrono::milliseconds JobPoller::kMaxInterval;
+
+static bool IsActive(const std::vector<std::string> &status)
+{
+    for (auto &s : status)
+        if (s == "PENDING" || s == "PRINTING")
+            return true;
+    return false;
+}
+
+bool JobPoller::IsFinal(const std::vector<std::string> &status)
+{
+    bool done = false;
+    for (auto &s : status)
+    {
+        if (s == "PRINTED" || s == "CANCELLED" || s == "ABORTED")
+            done = true;
+        else if (s == "PENDING" || s == "PRINTING" || s == "PAUSED" || s == "STOPPED")
+            return false;
+    }
+    return done;
+}
+
+JobPoller::JobPoller(PrinterService &service)
+    : service(service)
+{
+}
+
+JobPoller::~JobPoller()
+{
+    Stop();
+}
+
+uint64_t JobPoller::Add(const std::string &printerName, int jobId, std::shared_ptr<JobWatchListener> listener)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    if (stopping)
+        return 0;
+
+    uint64_t id = nextId++;
+    Watch &w = watches[id];
+    w.printerName = printerName;
+    w.jobId = jobId;
+    w.listener = std::move(listener);
+
+    if (!thread.joinable())
+        thread = std::thread(&JobPoller::Loop, this);
+
+    pollNow = true;
+    cv.notify_all();
+    return id;
+}
+
+void JobPoller::Remove(uint64_t id)
+{
+    std::shared_ptr<JobWatchListener> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = watches.find(id);
+        if (it == watches.end())
+            return;
+
+        dropped = std::move(it->second.listener);
+        watches.erase(it);
+    }
+}
+
+void JobPoller::Stop()
+{
+    std::map<uint64_t, Watch> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+        dropped.swap(watches);
+    }
+    cv.notify_all();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+bool JobPoller::Tick()
+{
+    // Watched ids per printer, leaving out jobs already final
+    std::map<std::string, std::set<int>> printers;
+    std::map<uint64_t, std::string> resolved;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto &kv : watches)
+            if (!IsFinal(kv.second.status))
+                resolved[kv.first] = kv.second.printerName;
+    }
+
+    for (auto &kv : resolved)
+        kv.second = service.ResolvePrinter(kv.second);
+
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto &kv : resolved)
+        {
+            auto w = watches.find(kv.first);
+            if (w != watches.end() && !kv.second.empty())
+                printers[kv.second].insert(w->second.jobId);
+        }
+    }
+
+    // Outside the lock. A job whose query failed is in neither map.
+    std::map<std::string, std::map<int, JobDetailsNative>> listed;
+    std::map<std::string, std::set<int>> missing;
+    for (auto &p : printers)
+    {
+        JobQueryNative query;
+        query.which = JobWhich::Active;
+        query.firstJobId = *p.second.begin();
+        query.fields = JOB_TIMES;
+
+        LastQueryFailed() = false;
+        auto jobs = service.Backend().GetJobs(p.first, query);
+        if (LastQueryFailed())
+            continue;
+
+        auto &byId = listed[p.first];
+        for (auto &j : jobs)
+            if (p.second.count(j.id))
+            {
+                int id = j.id;
+                byId[id] = std::move(j);
+            }
+
+        // Watched but no longer active: finished since the last tick
+        for (int id : p.second)
+        {
+            if (byId.count(id))
+                continue;
+
+            LastQueryFailed() = false;
+            auto j = service.Backend().GetJob(p.first, id);
+            if (!j.status.empty())
+                byId[id] = std::move(j);
+            else if (!LastQueryFailed())
+                missing[p.first].insert(id);
+        }
+    }
+
+    std::vector<std::pair<std::shared_ptr<JobWatchListener>, JobDetailsNative>> updates;
+    std::vector<std::shared_ptr<JobWatchListener>> gone;
+    bool active = false;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto it = watches.begin(); it != watches.end();)
+        {
+            Watch &w = it->second;
+            auto r = resolved.find(it->first);
+            if (r == resolved.end())
+            {
+                ++it;
+                continue;
+            }
+
+            auto m = missing.find(r->second);
+            if (m != missing.end() && m->second.count(w.jobId))
+            {
+                gone.push_back(std::move(w.listener));
+                it = watches.erase(it);
+                continue;
+            }
+
+            // Not answered this tick: nothing to report
+            auto l = listed.find(r->second);
+            if (l == listed.end() || !l->second.count(w.jobId))
+            {
+                ++it;
+                continue;
+            }
+
+            auto j = l->second.find(w.jobId);
+
+            active = active || IsActive(j->second.status);
+            if (j->second.status != w.status)
+            {
+                w.status = j->second.status;
+                updates.emplace_back(w.listener, j->second);
+            }
+            ++it;
+        }
+    }
+
+    for (auto &u : updates)
+        u.first->OnJobUpdate(u.second);
+    for (auto &g : gone)
+        g->OnJobMissing();
+
+    return active || !updates.empty();
+}
+
+void JobPoller::Loop()
+{
+    std::unique_lock<std::mutex> lock(mu);
+    auto interval = kMinInterval;
+
+    while (!stopping)
+    {
+        if (watches.empty())
+        {
+            cv.wait(lock, [this]() { return stopping || !watches.empty(); });
+            continue;
+        }
+
+        pollNow = false;
+        lock.unlock();
+        bool busy = Tick();
+        lock.lock();
+
+        // Fast while something moves, backing off while the queues idle
+        interval = busy ? kMinInterval : std::min(interval * 2, kMaxInterval);
+        cv.wait_for(lock, interval, [this]() { return stopping || pollNow; });
+    }
+}
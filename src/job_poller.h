@@ -0,0 +1,99 @@
+#ifndef JOB_POLLER_H
+#define JOB_POLLER_H
+
+#include "printer_interface.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PrinterService;
+
+class JobWatchListener
+{
+public:
+    virtual ~JobWatchListener() = default;
+
+    // On the poller thread: the job was seen for the first time or its
+    // status changed since the last call.
+    virtual void OnJobUpdate(const JobDetailsNative &job) = 0;
+
+    // On the poller thread: the printer answered but has no such job (it
+    // never existed there or was purged). The watch is already dropped.
+    virtual void OnJobMissing() {}
+};
+
+/*
+  Tracks job states for every watched job on one thread, for backends
+  without event subscriptions (or callers that do not want one).
+
+  Each tick groups the watched jobs by printer and asks the backend for
+  each printer's active jobs once (GetJobs from the lowest watched id,
+  status and times only), plus a GetJob for each watched job missing
+  from that listing: one that just left the active set. Only watchers
+  whose job changed state are notified. A job in a final state (printed,
+  cancelled, aborted) has nothing more to report and is not asked about
+  again; a job the printer does not have ends its watch.
+
+  The tick interval is kMinInterval while any watched job is pending or
+  printing and after a change, and doubles up to kMaxInterval while
+  nothing moves. A new watch is polled right away. The thread starts on
+  first use.
+*/
+class JobPoller
+{
+public:
+    static constexpr std::chrono::milliseconds kMinInterval{250};
+    static constexpr std::chrono::milliseconds kMaxInterval{5000};
+
+    // Printed, cancelled or aborted, with nothing still going on: the
+    // status will not change again.
+    static bool IsFinal(const std::vector<std::string> &status);
+
+    explicit JobPoller(PrinterService &service);
+    ~JobPoller();
+
+    JobPoller(const JobPoller &) = delete;
+    JobPoller &operator=(const JobPoller &) = delete;
+
+    // Empty printerName = the default printer. Returns an id for Remove.
+    uint64_t Add(const std::string &printerName, int jobId, std::shared_ptr<JobWatchListener> listener);
+
+    // The listener is released here or, when an OnJobUpdate call for it
+    // is in progress, right after that call.
+    void Remove(uint64_t id);
+
+    // Drops every watch and ends the thread; before the backend shuts down.
+    void Stop();
+
+private:
+    struct Watch
+    {
+        std::string printerName;
+        int jobId = 0;
+        std::shared_ptr<JobWatchListener> listener;
+        std::vector<std::string> status; // last reported, empty = none yet
+    };
+
+    void Loop();
+    bool Tick(); // true while some watched job is active
+
+    PrinterService &service;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::map<uint64_t, Watch> watches;
+    uint64_t nextId = 1;
+    bool pollNow = false;
+
+    std::thread thread;
+    bool stopping = false;
+};
+
+#endif
@@ -1,7 +1,6 @@
 #include "linux_printer.h"
 
 #include <cups/cups.h>
-#include <cups/ppd.h>
 #include <cups/ipp.h>
 #include <cups/http.h>
 
@@ -12,11 +11,34 @@
 #include <algorithm>
 #include <unistd.h>
 #include <cstring>
+#include <cstdlib>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <condition_variable>
+#include <mutex>
+#include <atomic>
 
 /* =========================================================
    Helpers
 ========================================================= */
 
+// Upload granularity for files: large enough to keep the socket busy,
+// small enough for smooth progress and bounded resident memory.
+static const size_t kFileChunkSize = 1024 * 1024;
+
+// Highest job id this process has seen on the server. Ids are global to
+// the server and only grow, so it bounds where recent jobs are listed.
+static std::atomic<int> newestJobId{0};
+
+static void NoteJobId(int jobId)
+{
+    int seen = newestJobId.load();
+    while (jobId > seen && !newestJobId.compare_exchange_weak(seen, jobId))
+    {
+    }
+}
+
 static std::string ToUpper(std::string s)
 {
     std::transform(s.begin(), s.end(), s.begin(),
@@ -24,6 +46,115 @@ static std::string ToUpper(std::string s)
     return s;
 }
 
+// Document format for cupsStartDocument. TEXT/COMMAND/AUTO go through as
+// raw bytes, like RAW, so the printer sees exactly what the caller sent
+// (AUTO always has: auto-typing would filter ESC/POS payloads as text).
+static const char *MimeForType(const std::string &type)
+{
+    std::string t = ToUpper(type);
+    if (t == "PDF") return CUPS_FORMAT_PDF;
+    if (t == "JPEG") return CUPS_FORMAT_JPEG;
+    if (t == "POSTSCRIPT") return CUPS_FORMAT_POSTSCRIPT;
+    return CUPS_FORMAT_RAW;
+}
+
+// cups_option_t array built from a StringMap, freed on scope exit
+struct CupsOptions
+{
+    int num = 0;
+    cups_option_t *list = nullptr;
+
+    explicit CupsOptions(const StringMap &options)
+    {
+        for (auto &kv : options)
+            num = cupsAddOption(kv.first.c_str(), kv.second.c_str(), num, &list);
+    }
+
+    ~CupsOptions()
+    {
+        if (list)
+            cupsFreeOptions(num, list);
+    }
+
+    CupsOptions(const CupsOptions &) = delete;
+    CupsOptions &operator=(const CupsOptions &) = delete;
+};
+
+// Sorts a failed submission into LastSubmitFailure() from cupsLastError()
+// and the connection's socket error. Must run before any other request
+// overwrites cupsLastError(). Timeouts are reported through LastTimeout().
+static void NoteSubmitFailure(http_t *http, bool jobMayExist)
+{
+    ipp_status_t st = cupsLastError();
+    int err = http ? httpError(http) : 0;
+
+    bool transient = st == IPP_STATUS_ERROR_SERVICE_UNAVAILABLE ||
+                     st == IPP_STATUS_ERROR_TEMPORARY ||
+                     st == IPP_STATUS_ERROR_BUSY ||
+                     err == ECONNRESET || err == ECONNREFUSED || err == EPIPE;
+
+    if (!transient)
+        LastSubmitFailure() = SubmitFailure::Permanent;
+    else
+        LastSubmitFailure() = jobMayExist ? SubmitFailure::TransientJobMayExist : SubmitFailure::Transient;
+}
+
+// After cancelling a job whose submission failed: a job that is known to
+// be gone can be retried like one that was never created.
+static void NoteJobCancelled(ipp_status_t cancelStatus)
+{
+    if (cancelStatus <= IPP_STATUS_OK_CONFLICTING &&
+        LastSubmitFailure() == SubmitFailure::TransientJobMayExist)
+        LastSubmitFailure() = SubmitFailure::Transient;
+}
+
+// Create-Job + Send-Document header on one connection. Returns the job id
+// with the document open for cupsWriteRequestData, or 0 (job cancelled).
+// An explicit job-priority option wins over `priority`.
+static int StartJob(http_t *http,
+                    const std::string &printerName,
+                    const char *format,
+                    const StringMap &options,
+                    int priority = 0,
+                    const std::string &jobName = std::string())
+{
+    const char *title = jobName.empty() ? "Node Print Job" : jobName.c_str();
+
+    CupsOptions opts(options);
+    if (priority > 0 && !options.count("job-priority"))
+        opts.num = cupsAddOption("job-priority", std::to_string(priority).c_str(), opts.num, &opts.list);
+    int jobId = cupsCreateJob(http, printerName.c_str(), title, opts.num, opts.list);
+    if (jobId <= 0)
+    {
+        NoteSubmitFailure(http, false);
+        return 0;
+    }
+    NoteJobId(jobId);
+
+    http_status_t st = cupsStartDocument(http, printerName.c_str(), jobId, title, format, 1);
+    if (st != HTTP_STATUS_CONTINUE)
+    {
+        NoteSubmitFailure(http, true);
+        NoteJobCancelled(cupsCancelJob2(http, printerName.c_str(), jobId, 0));
+        return 0;
+    }
+
+    return jobId;
+}
+
+// IPP request addressed to one job on the default server
+static ipp_t *NewJobRequest(ipp_op_t op, int jobId)
+{
+    char uri[HTTP_MAX_URI];
+    httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri), "ipp", NULL,
+                     "localhost", ippPort(), "/jobs/%d", jobId);
+
+    ipp_t *req = ippNewRequest(op);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI, "job-uri", NULL, uri);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    return req;
+}
+
 static std::vector<uint8_t> ReadAllBytes(const std::string &path)
 {
     std::ifstream f(path, std::ios::binary);
@@ -42,6 +173,32 @@ static std::vector<uint8_t> ReadAllBytes(const std::string &path)
     return buf;
 }
 
+static PrinterDetailsNative DestToDetails(const cups_dest_t &dest)
+{
+    PrinterDetailsNative p;
+    p.name = dest.name ? dest.name : "";
+    p.isDefault = dest.is_default != 0;
+
+    for (int k = 0; k < dest.num_options; k++)
+    {
+        if (dest.options[k].name && dest.options[k].value)
+            p.options[dest.options[k].name] = dest.options[k].value;
+    }
+
+    return p;
+}
+
+/* =========================================================
+   Lifecycle
+========================================================= */
+
+void LinuxPrinter::Shutdown()
+{
+    // Leased connections close as their calls finish; drop the rest now.
+    ppdCache.Clear();
+    pool.CloseIdle();
+}
+
 /* =========================================================
    Printer Listing
 ========================================================= */
@@ -50,23 +207,16 @@ std::vector<PrinterDetailsNative> LinuxPrinter::GetPrinters()
 {
     std::vector<PrinterDetailsNative> out;
 
+    auto conn = pool.Acquire();
+    if (!conn)
+        return out;
+
     cups_dest_t *dests = nullptr;
-    int num = cupsGetDests(&dests);
+    int num = cupsGetDests2(conn.get(), &dests);
 
+    out.reserve((size_t)(num > 0 ? num : 0));
     for (int i = 0; i < num; i++)
-    {
-        PrinterDetailsNative p;
-        p.name = dests[i].name ? dests[i].name : "";
-        p.isDefault = dests[i].is_default != 0;
-
-        for (int k = 0; k < dests[i].num_options; k++)
-        {
-            if (dests[i].options[k].name && dests[i].options[k].value)
-                p.options[dests[i].options[k].name] = dests[i].options[k].value;
-        }
-
-        out.push_back(std::move(p));
-    }
+        out.push_back(DestToDetails(dests[i]));
 
     cupsFreeDests(num, dests);
     return out;
@@ -74,21 +224,31 @@ std::vector<PrinterDetailsNative> LinuxPrinter::GetPrinters()
 
 PrinterDetailsNative LinuxPrinter::GetPrinter(const std::string &printerName)
 {
-    auto list = GetPrinters();
-    for (auto &p : list)
-        if (p.name == printerName)
-            return p;
+    // Single-destination query: cost does not depend on how many queues
+    // the server has, unlike enumerating with cupsGetDests.
+    auto conn = pool.Acquire();
+    cups_dest_t *dest = conn ? cupsGetNamedDest(conn.get(), printerName.c_str(), NULL) : nullptr;
+    if (!dest)
+    {
+        PrinterDetailsNative p;
+        p.name = printerName;
+        p.isDefault = false;
+        return p;
+    }
 
-    PrinterDetailsNative p;
-    p.name = printerName;
-    p.isDefault = false;
+    PrinterDetailsNative p = DestToDetails(*dest);
+    cupsFreeDests(1, dest);
     return p;
 }
 
 std::string LinuxPrinter::GetDefaultPrinterName()
 {
+    auto conn = pool.Acquire();
+    if (!conn)
+        return std::string();
+
     cups_dest_t *dests = nullptr;
-    int num = cupsGetDests(&dests);
+    int num = cupsGetDests2(conn.get(), &dests);
 
     cups_dest_t *def = cupsGetDest(NULL, NULL, num, dests);
 
@@ -100,75 +260,121 @@ std::string LinuxPrinter::GetDefaultPrinterName()
     return name;
 }
 
-/* =========================================================
-   Driver Options / Paper
-========================================================= */
-
-DriverOptions LinuxPrinter::GetPrinterDriverOptions(const std::string &printerName)
+std::string LinuxPrinter::GetPrintersChangeStamp()
 {
-    DriverOptions out;
-
-    const char *ppdPath = cupsGetPPD(printerName.c_str());
-    if (!ppdPath) return out;
-
-    ppd_file_t *ppd = ppdOpenFile(ppdPath);
-    if (!ppd)
+    // Only a local cupsd's files say anything; a remote server is followed
+    // through printer events and the registry TTL.
+    const char *server = cupsServer();
+    if (!server || (server[0] != '/' && strcmp(server, "localhost") != 0))
+        return std::string();
+
+    // cupsd rewrites printers.conf / classes.conf on every add, delete and
+    // modify; lpoptions carries the user's default and instance options.
+    const char *root = getenv("CUPS_SERVERROOT");
+    std::string serverRoot = root ? root : "/etc/cups";
+
+    std::vector<std::string> files = {
+        serverRoot + "/printers.conf",
+        serverRoot + "/classes.conf",
+        serverRoot + "/lpoptions",
+    };
+
+    const char *home = getenv("HOME");
+    if (home)
+        files.push_back(std::string(home) + "/.cups/lpoptions");
+
+    std::string stamp;
+    for (auto &f : files)
     {
-        unlink(ppdPath);
-        return out;
-    }
-
-    ppdMarkDefaults(ppd);
-
-    for (ppd_option_t *opt = ppd->options; opt; opt = opt->next)
-    {
-        std::map<std::string, bool> choices;
-
-        for (int i = 0; i < opt->num_choices; i++)
+        struct stat st;
+        if (stat(f.c_str(), &st) != 0)
         {
-            bool isDefault =
-                (opt->defchoice &&
-                 strcmp(opt->defchoice, opt->choices[i].choice) == 0);
-
-            choices[opt->choices[i].choice] = isDefault;
+            stamp += "-;";
+            continue;
         }
 
-        out[opt->keyword ? opt->keyword : ""] = choices;
+        stamp += std::to_string((long long)st.st_mtim.tv_sec) + "." +
+                 std::to_string((long)st.st_mtim.tv_nsec) + ":" +
+                 std::to_string((long long)st.st_size) + ";";
     }
 
-    ppdClose(ppd);
-    unlink(ppdPath);
+    return stamp;
+}
 
-    return out;
+/* =========================================================
+   Driver Options / Paper
+========================================================= */
+
+DriverOptions LinuxPrinter::GetPrinterDriverOptions(const std::string &printerName)
+{
+    auto caps = ppdCache.Get(printerName);
+    if (!caps)
+        return DriverOptions();
+
+    return caps->driverOptions;
 }
 
 std::string LinuxPrinter::GetSelectedPaperSize(const std::string &printerName)
 {
-    std::string paper;
+    auto caps = ppdCache.Get(printerName);
+    if (!caps)
+        return std::string();
+
+    return caps->selectedPaperSize;
+}
+
+PrinterSnapshotNative LinuxPrinter::GetPrinterSnapshot(const std::string &printerName, unsigned fields)
+{
+    PrinterSnapshotNative s;
 
-    const char *ppdPath = cupsGetPPD(printerName.c_str());
-    if (!ppdPath) return paper;
+    if (fields & SNAPSHOT_DETAILS)
+        s.details = GetPrinter(printerName);
 
-    ppd_file_t *ppd = ppdOpenFile(ppdPath);
-    if (!ppd)
+    // Options and paper size come from the same parsed PPD
+    if (fields & (SNAPSHOT_DRIVER_OPTIONS | SNAPSHOT_PAPER_SIZE))
     {
-        unlink(ppdPath);
-        return paper;
+        auto caps = ppdCache.Get(printerName);
+        if (caps && (fields & SNAPSHOT_DRIVER_OPTIONS))
+            s.driverOptions = caps->driverOptions;
+        if (caps && (fields & SNAPSHOT_PAPER_SIZE))
+            s.paperSize = caps->selectedPaperSize;
     }
 
-    ppdMarkDefaults(ppd);
+    s.fields = fields & SNAPSHOT_ALL;
+    return s;
+}
 
-    ppd_option_t *opt = ppdFindOption(ppd, "PageSize");
-    if (!opt)
-        opt = ppdFindOption(ppd, "PageRegion");
+CacheStatsNative LinuxPrinter::GetCapabilityCacheStats()
+{
+    return ppdCache.Stats();
+}
 
-    if (opt && opt->defchoice)
-        paper = opt->defchoice;
+void LinuxPrinter::SetCapabilityCacheLimits(size_t maxEntries, size_t maxBytes)
+{
+    ppdCache.SetLimits(maxEntries, maxBytes);
+}
 
-    ppdClose(ppd);
-    unlink(ppdPath);
+void LinuxPrinter::SetTimeouts(const CallTimeouts &timeouts)
+{
+    pool.SetTimeouts(timeouts);
+}
 
-    return paper;
+CallTimeouts LinuxPrinter::GetTimeouts()
+{
+    return pool.GetTimeouts();
+}
+
+// Gives up a job whose upload is mid-request on `conn`: the connection is
+// dropped and the job cancelled on another one.
+static void AbandonJob(CupsConnectionPool &pool,
+                       CupsConnectionPool::Lease &conn,
+                       const std::string &printerName,
+                       int jobId)
+{
+    conn.MarkBroken();
+    auto other = pool.Acquire();
+    if (other)
+        cupsCancelJob2(other.get(), printerName.c_str(), jobId, 0);
 }
 
 /* =========================================================
@@ -185,159 +391,701 @@ std::vector<std::string> LinuxPrinter::GetSupportedPrintFormats()
 ========================================================= */
 
 int LinuxPrinter::PrintDirect(const std::string &printerName,
-                              const std::vector<uint8_t> &data,
+                              ByteSpan data,
                               const std::string &type,
-                              const StringMap &options)
+                              const StringMap &options,
+                              const PrintControl &control)
 {
-    std::string t = ToUpper(type);
+    if (control.Cancelled())
+        return 0;
 
-    // For PDF/JPEG/POSTSCRIPT -> use temp file + cupsPrintFile
-    if (t == "PDF" || t == "JPEG" || t == "POSTSCRIPT")
+    auto conn = pool.Acquire(control.timeouts);
+    if (!conn)
     {
-        char tmpName[] = "/tmp/esslassi_print_XXXXXX";
-        int fd = mkstemp(tmpName);
-        if (fd < 0)
-            return 0;
+        LastSubmitFailure() = SubmitFailure::Transient;
+        return 0;
+    }
+    http_t *http = conn.get();
 
-        FILE *fp = fdopen(fd, "wb");
-        if (!fp)
+    // Every format goes straight over IPP with its MIME type; cupsd
+    // runs the filters, so nothing is staged on disk first.
+    int jobId = StartJob(http, printerName, MimeForType(type), options, control.priority, control.jobName);
+    if (jobId <= 0)
+        return 0;
+
+    // File-sized chunks: cancellation and the call's deadline are
+    // checked in between
+    bool wrote = true;
+    for (size_t off = 0; off < data.size && wrote; off += kFileChunkSize)
+    {
+        if (control.Cancelled() || conn.Expired())
         {
-            close(fd);
+            AbandonJob(pool, conn, printerName, jobId);
             return 0;
         }
 
-        fwrite(data.data(), 1, data.size(), fp);
-        fclose(fp);
+        size_t n = std::min(kFileChunkSize, data.size - off);
+        conn.Rearm();
+        wrote = cupsWriteRequestData(http, (const char *)data.data + off, n) == HTTP_STATUS_CONTINUE;
 
-        cups_option_t *cupOpts = nullptr;
-        int num = 0;
+        if (wrote && control.onProgress)
+            control.onProgress(off + n, data.size);
+    }
 
-        for (auto &kv : options)
-            num = cupsAddOption(kv.first.c_str(),
-                                kv.second.c_str(),
-                                num,
-                                &cupOpts);
+    if (!wrote)
+    {
+        NoteSubmitFailure(http, true);
 
-        int jobId = cupsPrintFile(
-            printerName.c_str(),
-            tmpName,
-            "Node Print Job",
-            num,
-            cupOpts);
+        // Close out the request before reusing the connection to cancel
+        cupsFinishDocument(http, printerName.c_str());
+        NoteJobCancelled(cupsCancelJob2(http, printerName.c_str(), jobId, 0));
+        conn.MarkBroken();
+        return 0;
+    }
 
-        if (cupOpts)
-            cupsFreeOptions(num, cupOpts);
+    conn.Rearm();
+    ipp_status_t fin = cupsFinishDocument(http, printerName.c_str());
+    if (fin > IPP_STATUS_OK_CONFLICTING)
+    {
+        NoteSubmitFailure(http, true);
+        return 0;
+    }
 
-        unlink(tmpName);
+    return jobId;
+}
+
+int LinuxPrinter::PrintFile(const std::string &printerName,
+                            const std::string &filename,
+                            const PrintControl &control)
+{
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
 
-        return jobId > 0 ? jobId : 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return 0;
     }
 
-    // RAW / TEXT / COMMAND
-    int jobId = cupsCreateJob(
-        CUPS_HTTP_DEFAULT,
-        printerName.c_str(),
-        "Node Print Job",
-        0,
-        NULL);
+    uint64_t total = S_ISREG(st.st_mode) ? (uint64_t)st.st_size : 0;
+
+    // Read through one reusable chunk buffer rather than mapped: a file
+    // truncated under a mapping raises SIGBUS, and cupsWriteRequestData
+    // copies into its own buffer either way.
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    auto conn = pool.Acquire(control.timeouts);
+    http_t *http = conn.get();
+
+    // cupsd types the document itself, as cupsPrintFile did
+    if (!conn)
+        LastSubmitFailure() = SubmitFailure::Transient;
 
+    int jobId = conn ? StartJob(http, printerName, CUPS_FORMAT_AUTO, StringMap(), control.priority, control.jobName) : 0;
     if (jobId <= 0)
+    {
+        close(fd);
         return 0;
+    }
 
-    http_status_t st = cupsStartDocument(
-        CUPS_HTTP_DEFAULT,
-        printerName.c_str(),
-        jobId,
-        "Node Print Job",
-        CUPS_FORMAT_RAW,
-        1);
+    bool ok = true;
+    bool abandon = false; // cancelled or out of time
+    uint64_t sent = 0;
 
-    if (st != HTTP_STATUS_CONTINUE)
+    std::vector<char> chunk(kFileChunkSize);
+    for (;;)
     {
-        cupsCancelJob(printerName.c_str(), jobId);
-        return 0;
+        if (control.Cancelled() || conn.Expired())
+        {
+            ok = false;
+            abandon = true;
+            break;
+        }
+
+        ssize_t n = read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+        {
+            ok = n == 0;
+            break;
+        }
+
+        conn.Rearm();
+        if (cupsWriteRequestData(http, chunk.data(), (size_t)n) != HTTP_STATUS_CONTINUE)
+        {
+            ok = false;
+            break;
+        }
+
+        sent += (uint64_t)n;
+        if (control.onProgress)
+            control.onProgress(sent, std::max(total, sent));
     }
 
-    if (cupsWriteRequestData(
-            CUPS_HTTP_DEFAULT,
-            (const char*)data.data(),
-            data.size()) != HTTP_STATUS_CONTINUE)
+    close(fd);
+
+    if (abandon)
     {
-        cupsCancelJob(printerName.c_str(), jobId);
+        AbandonJob(pool, conn, printerName, jobId);
         return 0;
     }
 
-    ipp_status_t fin =
-        (ipp_status_t)cupsFinishDocument(
-            CUPS_HTTP_DEFAULT,
-            printerName.c_str());
+    if (!ok)
+        NoteSubmitFailure(http, true);
 
-    if (fin > IPP_STATUS_OK_CONFLICT)
+    conn.Rearm();
+    ipp_status_t fin = cupsFinishDocument(http, printerName.c_str());
+    if (!ok)
+    {
+        NoteJobCancelled(cupsCancelJob2(http, printerName.c_str(), jobId, 0));
+        conn.MarkBroken();
+        return 0;
+    }
+
+    if (fin > IPP_STATUS_OK_CONFLICTING)
+    {
+        NoteSubmitFailure(http, true);
         return 0;
+    }
 
     return jobId;
 }
 
-int LinuxPrinter::PrintFile(const std::string &printerName,
-                            const std::string &filename)
+BatchResultNative LinuxPrinter::PrintBatch(const std::string &printerName,
+                                           const std::vector<BatchDocumentNative> &documents,
+                                           const StringMap &options)
 {
-    int jobId = cupsPrintFile(
-        printerName.c_str(),
-        filename.c_str(),
-        "Node Print Job",
-        0,
-        NULL);
+    BatchResultNative r;
+    if (documents.empty())
+        return r;
+
+    auto conn = pool.Acquire();
+    if (!conn)
+        return r;
+    http_t *http = conn.get();
+
+    CupsOptions opts(options);
+    r.jobId = cupsCreateJob(http, printerName.c_str(), "Node Print Job", opts.num, opts.list);
+    if (r.jobId <= 0)
+    {
+        r.jobId = 0;
+        return r;
+    }
+
+    // Send-Document per document on the same connection; only the final
+    // one carries last-document, which releases the job for printing.
+    bool lastSent = false;
+    bool lost = false; // a write failed: the connection is unusable
+    for (size_t i = 0; i < documents.size(); i++)
+    {
+        auto &doc = documents[i];
+        bool last = i + 1 == documents.size();
 
-    return jobId > 0 ? jobId : 0;
+        if (conn.Expired())
+        {
+            r.documentErrors.push_back("Timed out");
+            continue;
+        }
+        std::string docName = doc.name.empty() ? "Document " + std::to_string(i + 1) : doc.name;
+
+        conn.Rearm();
+        http_status_t st = cupsStartDocument(http, printerName.c_str(), r.jobId,
+                                             docName.c_str(), MimeForType(doc.type), last ? 1 : 0);
+        if (st != HTTP_STATUS_CONTINUE)
+        {
+            r.documentErrors.push_back(cupsLastErrorString());
+            continue;
+        }
+
+        conn.Rearm();
+        bool wrote = cupsWriteRequestData(http,
+                                          (const char *)doc.data.data,
+                                          doc.data.size) == HTTP_STATUS_CONTINUE;
+        if (!wrote)
+        {
+            conn.MarkBroken();
+            r.documentErrors.push_back("Document write failed");
+            for (size_t j = i + 1; j < documents.size(); j++)
+                r.documentErrors.push_back("Not sent: connection lost");
+            lost = true;
+            break;
+        }
+
+        conn.Rearm();
+        ipp_status_t fin = cupsFinishDocument(http, printerName.c_str());
+        if (fin > IPP_STATUS_OK_CONFLICTING)
+        {
+            r.documentErrors.push_back(cupsLastErrorString());
+            continue;
+        }
+
+        r.documentErrors.push_back("");
+        lastSent = last;
+    }
+
+    if (!lastSent)
+    {
+        // The job is still waiting for its last document: close it so
+        // what did arrive prints, or cancel it if nothing did (over a
+        // new connection when this one was lost).
+        bool anySent = false;
+        for (auto &e : r.documentErrors)
+            anySent = anySent || e.empty();
+
+        CupsConnectionPool::Lease other;
+        if (lost)
+        {
+            other = pool.Acquire();
+            http = other.get();
+        }
+
+        if (anySent && http)
+        {
+            ippDelete(cupsDoRequest(http, NewJobRequest(IPP_OP_CLOSE_JOB, r.jobId), "/jobs/"));
+            if (cupsLastError() <= IPP_STATUS_OK_CONFLICTING)
+                return r;
+        }
+
+        if (http)
+            cupsCancelJob2(http, printerName.c_str(), r.jobId, 0);
+        for (auto &e : r.documentErrors)
+            if (e.empty())
+                e = "Job cancelled: it could not be closed";
+        r.jobId = 0;
+    }
+
+    return r;
+}
+
+/* =========================================================
+   Streaming
+========================================================= */
+
+class LinuxPrintStream : public PrintStreamNative
+{
+public:
+    LinuxPrintStream(CupsConnectionPool &pool, CupsConnectionPool::Lease conn, std::string printerName, int jobId)
+        : pool(pool), conn(std::move(conn)), printerName(std::move(printerName)), jobId(jobId)
+    {}
+
+    ~LinuxPrintStream() override
+    {
+        Abort();
+    }
+
+    bool Write(ByteSpan chunk) override
+    {
+        // Blocks until the socket has taken the chunk: this is the
+        // backpressure the JS Writable waits on.
+        conn.Rearm();
+        return cupsWriteRequestData(conn.get(), (const char *)chunk.data, chunk.size) == HTTP_STATUS_CONTINUE;
+    }
+
+    int Finish() override
+    {
+        if (done)
+            return 0;
+        done = true;
+
+        conn.Rearm();
+        ipp_status_t st = cupsFinishDocument(conn.get(), printerName.c_str());
+        if (st <= IPP_STATUS_OK_CONFLICTING)
+            return jobId;
+
+        // cupsd would keep the half-received job until it aborts it
+        AbandonJob(pool, conn, printerName, jobId);
+        return 0;
+    }
+
+    void Abort() override
+    {
+        if (done)
+            return;
+        done = true;
+
+        AbandonJob(pool, conn, printerName, jobId);
+    }
+
+private:
+    CupsConnectionPool &pool;
+    CupsConnectionPool::Lease conn;
+    std::string printerName;
+    int jobId;
+    bool done = false;
+};
+
+std::unique_ptr<PrintStreamNative> LinuxPrinter::OpenPrintStream(const std::string &printerName,
+                                                                 const std::string &type,
+                                                                 const StringMap &options)
+{
+    // A dedicated connection, held for the whole document: it stays open
+    // across calls from the stream thread.
+    auto conn = pool.AcquireDedicated();
+    if (!conn)
+        return nullptr;
+
+    int jobId = StartJob(conn.get(), printerName, MimeForType(type), options);
+    if (jobId <= 0)
+        return nullptr;
+
+    return std::unique_ptr<PrintStreamNative>(new LinuxPrintStream(pool, std::move(conn), printerName, jobId));
 }
 
 /* =========================================================
    Job Management
 ========================================================= */
 
+static std::vector<std::string> JobStatus(ipp_jstate_t state)
+{
+    switch (state)
+    {
+        case IPP_JSTATE_PENDING:    return { "PENDING" };
+        case IPP_JSTATE_HELD:       return { "PAUSED" };
+        case IPP_JSTATE_PROCESSING: return { "PRINTING" };
+        case IPP_JSTATE_STOPPED:    return { "STOPPED" }; // waiting on the printer, not final
+        case IPP_JSTATE_CANCELED:   return { "CANCELLED" };
+        case IPP_JSTATE_ABORTED:    return { "ABORTED" };
+        case IPP_JSTATE_COMPLETED:  return { "PRINTED" };
+        default:                    return { "PENDING" };
+    }
+}
+
+// requested-attributes for the JobDetailsNative parts in `fields`
+static std::vector<const char *> JobAttributes(unsigned fields)
+{
+    std::vector<const char *> attrs = { "job-id", "job-printer-uri", "job-state" };
+    if (fields & JOB_NAME)
+        attrs.push_back("job-name");
+    if (fields & JOB_USER)
+        attrs.push_back("job-originating-user-name");
+    if (fields & JOB_FORMAT)
+        attrs.push_back("document-format");
+    if (fields & JOB_PRIORITY)
+        attrs.push_back("job-priority");
+    if (fields & JOB_SIZE)
+        attrs.push_back("job-k-octets");
+    if (fields & JOB_TIMES)
+    {
+        attrs.push_back("time-at-creation");
+        attrs.push_back("time-at-processing");
+        attrs.push_back("time-at-completed");
+    }
+    return attrs;
+}
+
+// Copies one job attribute of a Get-Job-Attributes / Get-Jobs response;
+// job-printer-uri becomes the queue name.
+static void ReadJobAttribute(JobDetailsNative &j, ipp_attribute_t *attr)
+{
+    const char *name = ippGetName(attr);
+    ipp_tag_t tag = ippGetValueTag(attr);
+    bool text = tag == IPP_TAG_NAME || tag == IPP_TAG_NAMELANG || tag == IPP_TAG_MIMETYPE;
+    bool integer = tag == IPP_TAG_INTEGER;
+
+    if (!strcmp(name, "job-id") && integer)
+        j.id = ippGetInteger(attr, 0);
+    else if (!strcmp(name, "job-state") && tag == IPP_TAG_ENUM)
+        j.status = JobStatus((ipp_jstate_t)ippGetInteger(attr, 0));
+    else if (!strcmp(name, "job-printer-uri") && tag == IPP_TAG_URI)
+    {
+        const char *uri = ippGetString(attr, 0, NULL);
+        const char *slash = uri ? strrchr(uri, '/') : NULL;
+        if (slash)
+            j.printerName = slash + 1;
+    }
+    else if (!strcmp(name, "job-name") && text)
+        j.name = ippGetString(attr, 0, NULL);
+    else if (!strcmp(name, "job-originating-user-name") && text)
+        j.user = ippGetString(attr, 0, NULL);
+    else if (!strcmp(name, "document-format") && text)
+        j.format = ippGetString(attr, 0, NULL);
+    else if (!strcmp(name, "job-priority") && integer)
+        j.priority = ippGetInteger(attr, 0);
+    else if (!strcmp(name, "job-k-octets") && integer)
+        j.size = ippGetInteger(attr, 0);
+    else if (!strcmp(name, "time-at-creation") && integer)
+        j.creationTime = ippGetInteger(attr, 0);
+    else if (!strcmp(name, "time-at-processing") && integer)
+        j.processingTime = ippGetInteger(attr, 0);
+    else if (!strcmp(name, "time-at-completed") && integer)
+        j.completedTime = ippGetInteger(attr, 0);
+}
+
 JobDetailsNative LinuxPrinter::GetJob(const std::string &printerName, int jobId)
 {
     JobDetailsNative j;
     j.id = jobId;
     j.printerName = printerName;
 
-    cups_job_t *jobs = nullptr;
-    int num = cupsGetJobs(&jobs,
-                          printerName.c_str(),
-                          0,
-                          CUPS_WHICHJOBS_ALL);
+    auto conn = pool.Acquire();
+    if (!conn)
+    {
+        LastQueryFailed() = true;
+        return j;
+    }
 
-    for (int i = 0; i < num; i++)
+    // Get-Job-Attributes for this one job: the cost no longer grows with
+    // the queue's retained history the way a Get-Jobs scan did.
+    auto attrs = JobAttributes(JOB_ALL);
+
+    ipp_t *req = NewJobRequest(IPP_OP_GET_JOB_ATTRIBUTES, jobId);
+    ippAddStrings(req, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes",
+                  (int)attrs.size(), NULL, attrs.data());
+
+    ipp_t *resp = cupsDoRequest(conn.get(), req, "/jobs/");
+    if (!resp || cupsLastError() > IPP_STATUS_OK_CONFLICTING)
     {
-        if (jobs[i].id == jobId)
+        if (cupsLastError() != IPP_STATUS_ERROR_NOT_FOUND)
+            LastQueryFailed() = true;
+        ippDelete(resp);
+        return j;
+    }
+
+    JobDetailsNative found;
+    for (ipp_attribute_t *attr = ippFirstAttribute(resp); attr; attr = ippNextAttribute(resp))
+        if (ippGetGroupTag(attr) == IPP_TAG_JOB && ippGetName(attr))
+            ReadJobAttribute(found, attr);
+    ippDelete(resp);
+
+    // Ids are global to the server; a job on another queue is not this one
+    if (!printerName.empty() && !found.printerName.empty() && found.printerName != printerName)
+        return j;
+
+    found.id = jobId;
+    found.printerName = printerName;
+    NoteJobId(jobId);
+    return found;
+}
+
+std::vector<JobDetailsNative> LinuxPrinter::GetJobs(const std::string &printerName, const JobQueryNative &query)
+{
+    std::vector<JobDetailsNative> out;
+
+    auto conn = pool.Acquire();
+    if (!conn)
+    {
+        LastQueryFailed() = true;
+        return out;
+    }
+
+    char uri[HTTP_MAX_URI];
+    if (printerName.empty())
+        snprintf(uri, sizeof(uri), "ipp://localhost/");
+    else
+        httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri), "ipp", NULL,
+                         "localhost", ippPort(), "/printers/%s", printerName.c_str());
+
+    const char *which = query.which == JobWhich::Completed ? "completed"
+                      : query.which == JobWhich::All       ? "all"
+                                                           : "not-completed";
+
+    // The user filter is asked of the server (my-jobs) and checked again
+    // here, so the user's name is always requested.
+    auto attrs = JobAttributes(query.fields | (query.user.empty() ? 0u : (unsigned)JOB_USER));
+
+    ipp_t *req = ippNewRequest(IPP_OP_GET_JOBS);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL,
+                 query.user.empty() ? cupsUser() : query.user.c_str());
+    if (!query.user.empty())
+        ippAddBoolean(req, IPP_TAG_OPERATION, "my-jobs", 1);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, which);
+    // Pages are by job id. cupsd lists completed and all jobs from its
+    // id-ordered job list, but not-completed ones from the scheduling
+    // order (priority, then id), where a limited page could skip a lower
+    // id that the next page (last id + 1) never returns. Active listings
+    // are therefore not limited on the server; they are sorted by id here
+    // and truncated.
+    bool serverLimit = query.which != JobWhich::Active;
+    if (query.limit > 0 && serverLimit)
+        ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit", query.limit);
+    if (query.firstJobId > 0)
+        ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "first-job-id", query.firstJobId);
+    ippAddStrings(req, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes",
+                  (int)attrs.size(), NULL, attrs.data());
+
+    ipp_t *resp = cupsDoRequest(conn.get(), req, "/");
+    if (!resp || cupsLastError() > IPP_STATUS_OK_CONFLICTING)
+    {
+        LastQueryFailed() = true;
+        ippDelete(resp);
+        return out;
+    }
+
+    // Jobs are consecutive job groups, split by separators
+    bool inJob = false;
+    for (ipp_attribute_t *attr = ippFirstAttribute(resp); attr; attr = ippNextAttribute(resp))
+    {
+        if (ippGetGroupTag(attr) != IPP_TAG_JOB || !ippGetName(attr))
+        {
+            inJob = false;
+            continue;
+        }
+
+        if (!inJob)
         {
-            j.name = jobs[i].title ? jobs[i].title : "";
-            j.user = jobs[i].user ? jobs[i].user : "";
-            j.format = jobs[i].format ? jobs[i].format : "";
-            j.priority = jobs[i].priority;
-            j.size = jobs[i].size;
+            out.emplace_back();
+            out.back().printerName = printerName;
+            inJob = true;
+        }
+        ReadJobAttribute(out.back(), attr);
+    }
+    ippDelete(resp);
+
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [&query](const JobDetailsNative &j) { return j.id <= 0 || !query.Matches(j); }),
+              out.end());
+
+    // Active jobs come back in scheduling order
+    std::sort(out.begin(), out.end(),
+              [](const JobDetailsNative &a, const JobDetailsNative &b) { return a.id < b.id; });
+    if (!out.empty())
+        NoteJobId(out.back().id);
+    if (query.limit > 0 && out.size() > (size_t)query.limit)
+        out.resize((size_t)query.limit);
+    return out;
+}
 
-            switch (jobs[i].state)
+// What FindJobByName needs to know about one of the user's jobs
+struct OwnJob
+{
+    int id = 0;
+    std::string name;
+    ipp_jstate_t state = IPP_JSTATE_PENDING;
+    int documents = 0;     // number-of-documents received
+    bool incoming = false; // job-state-reasons job-incoming: still being sent
+};
+
+// Job ids FindJobByName searches for completed jobs, ending at the
+// newest one seen (cupsd's default MaxJobs retains no more than this)
+static const int kRecentCompletedJobs = 500;
+
+// Get-Jobs for this user's jobs on printerName, with only the attributes
+// OwnJob holds. False if the request failed.
+static bool ListOwnJobs(http_t *http,
+                        const std::string &printerName,
+                        const char *which,
+                        int firstJobId,
+                        int limit,
+                        std::vector<OwnJob> &out)
+{
+    static const char *const attrs[] = {
+        "job-id", "job-name", "job-state", "job-state-reasons", "number-of-documents"
+    };
+
+    char uri[HTTP_MAX_URI];
+    httpAssembleURIf(HTTP_URI_CODING_ALL, uri, sizeof(uri), "ipp", NULL,
+                     "localhost", ippPort(), "/printers/%s", printerName.c_str());
+
+    ipp_t *req = ippNewRequest(IPP_OP_GET_JOBS);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, uri);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    ippAddBoolean(req, IPP_TAG_OPERATION, "my-jobs", 1);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "which-jobs", NULL, which);
+    if (limit > 0)
+        ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "limit", limit);
+    if (firstJobId > 0)
+        ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "first-job-id", firstJobId);
+    ippAddStrings(req, IPP_TAG_OPERATION, IPP_TAG_KEYWORD, "requested-attributes",
+                  (int)(sizeof(attrs) / sizeof(attrs[0])), NULL, attrs);
+
+    ipp_t *resp = cupsDoRequest(http, req, "/");
+    ipp_status_t st = cupsLastError();
+    if (!resp || (st > IPP_STATUS_OK_CONFLICTING && st != IPP_STATUS_ERROR_NOT_FOUND))
+    {
+        ippDelete(resp);
+        return false;
+    }
+
+    bool inJob = false;
+    for (ipp_attribute_t *attr = ippFirstAttribute(resp); attr; attr = ippNextAttribute(resp))
+    {
+        const char *name = ippGetName(attr);
+        if (ippGetGroupTag(attr) != IPP_TAG_JOB || !name)
+        {
+            inJob = false;
+            continue;
+        }
+
+        if (!inJob)
+        {
+            out.emplace_back();
+            inJob = true;
+        }
+
+        OwnJob &j = out.back();
+        if (!strcmp(name, "job-id"))
+            j.id = ippGetInteger(attr, 0);
+        else if (!strcmp(name, "job-name") && ippGetString(attr, 0, NULL))
+            j.name = ippGetString(attr, 0, NULL);
+        else if (!strcmp(name, "job-state"))
+            j.state = (ipp_jstate_t)ippGetInteger(attr, 0);
+        else if (!strcmp(name, "number-of-documents"))
+            j.documents = ippGetInteger(attr, 0);
+        else if (!strcmp(name, "job-state-reasons"))
+        {
+            for (int i = 0; i < ippGetCount(attr); i++)
             {
-                case IPP_JSTATE_PENDING:    j.status = { "PENDING" }; break;
-                case IPP_JSTATE_HELD:       j.status = { "PAUSED" }; break;
-                case IPP_JSTATE_PROCESSING: j.status = { "PRINTING" }; break;
-                case IPP_JSTATE_STOPPED:    j.status = { "ABORTED" }; break;
-                case IPP_JSTATE_CANCELED:   j.status = { "CANCELLED" }; break;
-                case IPP_JSTATE_ABORTED:    j.status = { "ABORTED" }; break;
-                case IPP_JSTATE_COMPLETED:  j.status = { "PRINTED" }; break;
-                default:                    j.status = { "PENDING" }; break;
+                const char *reason = ippGetString(attr, i, NULL);
+                j.incoming = j.incoming || (reason && !strcmp(reason, "job-incoming"));
             }
-
-            j.creationTime = jobs[i].creation_time;
-            j.processingTime = jobs[i].processing_time;
-            j.completedTime = jobs[i].completed_time;
-            break;
         }
     }
+    ippDelete(resp);
+    return true;
+}
 
-    cupsFreeJobs(num, jobs);
-    return j;
+int LinuxPrinter::FindJobByName(const std::string &printerName, const std::string &jobName)
+{
+    auto conn = pool.Acquire();
+    if (!conn)
+        return -1;
+
+    // Only this user's jobs: a resubmission is always made as the same
+    // user. Completed ones are listed in id order, so the search starts
+    // kRecentCompletedJobs ids below the newest id known here (including
+    // the user's active jobs just listed) and is limited to that many.
+    std::vector<OwnJob> jobs;
+    if (!ListOwnJobs(conn.get(), printerName, "not-completed", 0, 0, jobs))
+        return -1;
+    for (auto &j : jobs)
+        NoteJobId(j.id);
+
+    int newest = newestJobId.load();
+    if (newest > 0 &&
+        !ListOwnJobs(conn.get(), printerName, "completed", std::max(1, newest - kRecentCompletedJobs + 1),
+                     kRecentCompletedJobs, jobs))
+        return -1;
+
+    int found = 0;
+    std::vector<int> orphans;
+    for (auto &j : jobs)
+    {
+        if (j.id <= 0 || j.name != jobName)
+            continue;
+
+        bool submitted = j.state == IPP_JSTATE_COMPLETED ||
+                         j.state == IPP_JSTATE_PROCESSING ||
+                         ((j.state == IPP_JSTATE_PENDING || j.state == IPP_JSTATE_HELD ||
+                           j.state == IPP_JSTATE_STOPPED) &&
+                          j.documents > 0 && !j.incoming);
+
+        // Newest wins if a key was reused
+        if (submitted)
+            found = std::max(found, j.id);
+        else if (j.state < IPP_JSTATE_CANCELED)
+            orphans.push_back(j.id);
+    }
+
+    // Created by a failed attempt that never finished sending its
+    // document: it would never print, cupsd would only abort it later
+    for (int id : orphans)
+        cupsCancelJob2(conn.get(), printerName.c_str(), id, 0);
+
+    return found;
 }
 
 void LinuxPrinter::SetJob(const std::string &printerName,
@@ -346,21 +1094,25 @@ void LinuxPrinter::SetJob(const std::string &printerName,
 {
     std::string cmd = ToUpper(command);
 
+    auto conn = pool.Acquire();
+    if (!conn)
+        return;
+
     if (cmd == "CANCEL")
     {
-        cupsCancelJob(printerName.c_str(), jobId);
+        cupsCancelJob2(conn.get(), printerName.c_str(), jobId, 0);
         return;
     }
 
     if (cmd == "PAUSE" || cmd == "HOLD")
     {
-        cupsHoldJob(printerName.c_str(), jobId);
+        ippDelete(cupsDoRequest(conn.get(), NewJobRequest(IPP_OP_HOLD_JOB, jobId), "/jobs/"));
         return;
     }
 
     if (cmd == "RESUME" || cmd == "RELEASE")
     {
-        cupsReleaseJob(printerName.c_str(), jobId);
+        ippDelete(cupsDoRequest(conn.get(), NewJobRequest(IPP_OP_RELEASE_JOB, jobId), "/jobs/"));
         return;
     }
 }
@@ -368,4 +1120,238 @@ void LinuxPrinter::SetJob(const std::string &printerName,
 std::vector<std::string> LinuxPrinter::GetSupportedJobCommands()
 {
     return { "CANCEL", "PAUSE", "RESUME" };
-}
\ No newline at end of file
+}
+/* =========================================================
+   Events
+========================================================= */
+
+// One ippget subscription on every printer. Get-Notifications asks the
+// server to hold the request until there are events (notify-wait);
+// cupsd answers at once instead, so an empty answer is followed by a
+// short pause before the next request.
+class LinuxEventSource : public PrinterEventSourceNative
+{
+public:
+    static const int kLeaseSeconds = 300;
+    static constexpr std::chrono::seconds kRenewEvery{120};
+    static constexpr std::chrono::milliseconds kMaxPause{1000};
+
+    LinuxEventSource(CupsConnectionPool &pool, CupsConnectionPool::Lease conn, int subscriptionId)
+        : pool(pool), conn(std::move(conn)), subscriptionId(subscriptionId),
+          renewAt(std::chrono::steady_clock::now() + kRenewEvery)
+    {}
+
+    ~LinuxEventSource() override
+    {
+        // On a fresh lease: this one may have been shut down by Interrupt
+        conn = CupsConnectionPool::Lease();
+        auto c = pool.Acquire();
+        if (c)
+            ippDelete(cupsDoRequest(c.get(), NewRequest(IPP_OP_CANCEL_SUBSCRIPTION), "/"));
+    }
+
+    bool Next(std::vector<PrinterEventNative> &out) override
+    {
+        for (;;)
+        {
+            if (interrupted)
+                return false;
+
+            if (std::chrono::steady_clock::now() >= renewAt)
+            {
+                ipp_t *req = NewRequest(IPP_OP_RENEW_SUBSCRIPTION);
+                ippAddInteger(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration", kLeaseSeconds);
+                ippDelete(cupsDoRequest(conn.get(), req, "/"));
+                if (cupsLastError() > IPP_STATUS_OK_CONFLICTING)
+                    return Lost();
+                renewAt = std::chrono::steady_clock::now() + kRenewEvery;
+            }
+
+            ipp_t *req = ippNewRequest(IPP_OP_GET_NOTIFICATIONS);
+            AddTarget(req);
+            ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-ids", subscriptionId);
+            ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-sequence-numbers", nextSequence);
+            ippAddBoolean(req, IPP_TAG_OPERATION, "notify-wait", 1);
+
+            ipp_t *resp = cupsDoRequest(conn.get(), req, "/");
+            if (!resp || cupsLastError() > IPP_STATUS_OK_CONFLICTING)
+            {
+                ippDelete(resp);
+                return Lost();
+            }
+
+            size_t before = out.size();
+            ReadEvents(resp, out);
+
+            int interval = 0;
+            ipp_attribute_t *attr = ippFindAttribute(resp, "notify-get-interval", IPP_TAG_INTEGER);
+            if (attr)
+                interval = ippGetInteger(attr, 0);
+            ippDelete(resp);
+
+            if (out.size() > before)
+                return true;
+
+            auto pause = std::chrono::milliseconds(std::max(interval, 0) * 1000);
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait_for(lock, std::min(pause, std::chrono::milliseconds(kMaxPause)), [this]() { return interrupted.load(); });
+        }
+    }
+
+    void Interrupt() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            interrupted = true;
+        }
+        cv.notify_all();
+
+        // Wakes a request the server is holding
+        httpShutdown(conn.get());
+    }
+
+private:
+    // printer-uri, requesting-user-name and, when set, the subscription id
+    ipp_t *NewRequest(ipp_op_t op)
+    {
+        ipp_t *req = ippNewRequest(op);
+        AddTarget(req);
+        ippAddInteger(req, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "notify-subscription-id", subscriptionId);
+        return req;
+    }
+
+    static void AddTarget(ipp_t *req)
+    {
+        ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/");
+        ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    }
+
+    bool Lost()
+    {
+        conn.MarkBroken();
+        return false;
+    }
+
+    // Event groups are split by separators, like job groups
+    void ReadEvents(ipp_t *resp, std::vector<PrinterEventNative> &out)
+    {
+        size_t first = out.size();
+        std::vector<bool> fromPrinter; // status came from printer-state, per event
+        bool inEvent = false;
+        for (ipp_attribute_t *attr = ippFirstAttribute(resp); attr; attr = ippNextAttribute(resp))
+        {
+            const char *name = ippGetName(attr);
+            if (ippGetGroupTag(attr) != IPP_TAG_EVENT_NOTIFICATION || !name)
+            {
+                inEvent = false;
+                continue;
+            }
+
+            if (!inEvent)
+            {
+                out.emplace_back();
+                out.back().time = time(NULL);
+                fromPrinter.push_back(false);
+                inEvent = true;
+            }
+
+            PrinterEventNative &e = out.back();
+            ipp_tag_t tag = ippGetValueTag(attr);
+
+            if (!strcmp(name, "notify-subscribed-event") && tag == IPP_TAG_KEYWORD)
+                e.event = ippGetString(attr, 0, NULL);
+            else if (!strcmp(name, "notify-sequence-number") && tag == IPP_TAG_INTEGER)
+                nextSequence = std::max(nextSequence, ippGetInteger(attr, 0) + 1);
+            else if (!strcmp(name, "notify-job-id") && tag == IPP_TAG_INTEGER)
+                e.jobId = ippGetInteger(attr, 0);
+            else if (!strcmp(name, "job-state") && tag == IPP_TAG_ENUM)
+            {
+                e.status = JobStatus((ipp_jstate_t)ippGetInteger(attr, 0));
+                fromPrinter.back() = false;
+            }
+            else if (!strcmp(name, "printer-state") && tag == IPP_TAG_ENUM && !e.jobId &&
+                     (e.status.empty() || fromPrinter.back()))
+            {
+                e.status = { PrinterState(ippGetInteger(attr, 0)) };
+                fromPrinter.back() = true;
+            }
+            else if (!strcmp(name, "notify-text") && (tag == IPP_TAG_TEXT || tag == IPP_TAG_TEXTLANG))
+                e.message = ippGetString(attr, 0, NULL);
+            else if (!strcmp(name, "printer-name") && (tag == IPP_TAG_NAME || tag == IPP_TAG_NAMELANG))
+                e.printerName = ippGetString(attr, 0, NULL);
+            else if (!strcmp(name, "notify-printer-uri") && tag == IPP_TAG_URI && e.printerName.empty())
+            {
+                const char *uri = ippGetString(attr, 0, NULL);
+                const char *slash = uri ? strrchr(uri, '/') : NULL;
+                if (slash)
+                    e.printerName = slash + 1;
+            }
+        }
+
+        // Job events carry both states; the job's is the one that matters,
+        // and printer-state read before notify-job-id is dropped
+        for (size_t i = 0; i < fromPrinter.size(); i++)
+            if (fromPrinter[i] && out[first + i].jobId)
+                out[first + i].status.clear();
+    }
+
+    static const char *PrinterState(int state)
+    {
+        switch (state)
+        {
+            case IPP_PSTATE_IDLE:       return "IDLE";
+            case IPP_PSTATE_PROCESSING: return "PROCESSING";
+            default:                    return "STOPPED";
+        }
+    }
+
+    CupsConnectionPool &pool;
+    CupsConnectionPool::Lease conn;
+    int subscriptionId;
+    int nextSequence = 1;
+    std::chrono::steady_clock::time_point renewAt;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::atomic<bool> interrupted{false};
+};
+
+constexpr std::chrono::seconds LinuxEventSource::kRenewEvery;
+constexpr std::chrono::milliseconds LinuxEventSource::kMaxPause;
+
+std::unique_ptr<PrinterEventSourceNative> LinuxPrinter::OpenEventSource(const std::set<std::string> &events)
+{
+    if (events.empty())
+        return nullptr;
+
+    // A dedicated connection, held for the subscription's lifetime; a
+    // server that honours notify-wait may keep a request open for a while.
+    CallTimeouts timeouts;
+    timeouts.readMs = 90000;
+    auto conn = pool.AcquireDedicated(timeouts);
+    if (!conn)
+        return nullptr;
+
+    std::vector<const char *> keywords;
+    for (auto &e : events)
+        keywords.push_back(e.c_str());
+
+    ipp_t *req = ippNewRequest(IPP_OP_CREATE_PRINTER_SUBSCRIPTIONS);
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_URI, "printer-uri", NULL, "ipp://localhost/");
+    ippAddString(req, IPP_TAG_OPERATION, IPP_TAG_NAME, "requesting-user-name", NULL, cupsUser());
+    ippAddString(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-pull-method", NULL, "ippget");
+    ippAddStrings(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_KEYWORD, "notify-events",
+                  (int)keywords.size(), NULL, keywords.data());
+    ippAddInteger(req, IPP_TAG_SUBSCRIPTION, IPP_TAG_INTEGER, "notify-lease-duration",
+                  LinuxEventSource::kLeaseSeconds);
+
+    ipp_t *resp = cupsDoRequest(conn.get(), req, "/");
+    ipp_attribute_t *attr = resp ? ippFindAttribute(resp, "notify-subscription-id", IPP_TAG_INTEGER) : NULL;
+    int subscriptionId = attr ? ippGetInteger(attr, 0) : 0;
+    ippDelete(resp);
+
+    if (subscriptionId <= 0)
+        return nullptr;
+
+    return std::unique_ptr<PrinterEventSourceNative>(new LinuxEventSource(pool, std::move(conn), subscriptionId));
+}
@@ -2,30 +2,65 @@
 #define LINUX_PRINTER_H
 
 #include "printer_interface.h"
+#include "cups_connection_pool.h"
+#include "ppd_cache.h"
 
 class LinuxPrinter : public PrinterInterface
 {
 public:
+    LinuxPrinter() : ppdCache(pool) {}
+
+    void Shutdown() override;
+
     std::vector<PrinterDetailsNative> GetPrinters() override;
     PrinterDetailsNative GetPrinter(const std::string &printerName) override;
     std::string GetDefaultPrinterName() override;
+    std::string GetPrintersChangeStamp() override;
 
     DriverOptions GetPrinterDriverOptions(const std::string &printerName) override;
     std::string GetSelectedPaperSize(const std::string &printerName) override;
 
+    PrinterSnapshotNative GetPrinterSnapshot(const std::string &printerName, unsigned fields) override;
+
+    CacheStatsNative GetCapabilityCacheStats() override;
+    void SetCapabilityCacheLimits(size_t maxEntries, size_t maxBytes) override;
+
+    void SetTimeouts(const CallTimeouts &timeouts) override;
+    CallTimeouts GetTimeouts() override;
+
     int PrintDirect(const std::string &printerName,
-                    const std::vector<uint8_t> &data,
+                    ByteSpan data,
                     const std::string &type,
-                    const StringMap &options) override;
+                    const StringMap &options,
+                    const PrintControl &control) override;
 
     int PrintFile(const std::string &printerName,
-                  const std::string &filename) override;
+                  const std::string &filename,
+                  const PrintControl &control) override;
+
+    BatchResultNative PrintBatch(const std::string &printerName,
+                                 const std::vector<BatchDocumentNative> &documents,
+                                 const StringMap &options) override;
+
+    int FindJobByName(const std::string &printerName, const std::string &jobName) override;
+
+    std::unique_ptr<PrintStreamNative> OpenPrintStream(const std::string &printerName,
+                                                       const std::string &type,
+                                                       const StringMap &options) override;
+
+    bool SupportsEvents() override { return true; }
+    std::unique_ptr<PrinterEventSourceNative> OpenEventSource(const std::set<std::string> &events) override;
 
     std::vector<std::string> GetSupportedPrintFormats() override;
 
     JobDetailsNative GetJob(const std::string &printerName, int jobId) override;
+    std::vector<JobDetailsNative> GetJobs(const std::string &printerName, const JobQueryNative &query) override;
     void SetJob(const std::string &printerName, int jobId, const std::string &command) override;
     std::vector<std::string> GetSupportedJobCommands() override;
+
+private:
+    CupsConnectionPool pool;
+    PpdCache ppdCache;
 };
 
 #endif
\ No newline at end of file
@@ -17,6 +17,9 @@
    Helpers
 ========================================================= */
 
+// Upload granularity when the caller follows progress or may cancel
+static const size_t kProgressChunkSize = 1024 * 1024;
+
 static std::string ToUpper(std::string s)
 {
     std::transform(s.begin(), s.end(), s.begin(),
@@ -185,11 +188,20 @@ std::vector<std::string> MacPrinter::GetSupportedPrintFormats()
 ========================================================= */
 
 int MacPrinter::PrintDirect(const std::string &printerName,
-                            const std::vector<uint8_t> &data,
+                            ByteSpan data,
                             const std::string &type,
-                            const StringMap &options)
+                            const StringMap &options,
+                            const PrintControl &control)
 {
+    if (control.Cancelled())
+        return 0;
+
     std::string t = ToUpper(type);
+    const char *title = control.jobName.empty() ? "Node Print Job" : control.jobName.c_str();
+
+    StringMap jobOptions = options;
+    if (control.priority > 0 && !jobOptions.count("job-priority"))
+        jobOptions["job-priority"] = std::to_string(control.priority);
 
     // For PDF/JPEG/POSTSCRIPT -> use temp file + cupsPrintFile
     if (t == "PDF" || t == "JPEG" || t == "POSTSCRIPT")
@@ -206,13 +218,13 @@ int MacPrinter::PrintDirect(const std::string &printerName,
             return 0;
         }
 
-        fwrite(data.data(), 1, data.size(), fp);
+        fwrite(data.data, 1, data.size, fp);
         fclose(fp);
 
         cups_option_t *cupOpts = nullptr;
         int num = 0;
 
-        for (auto &kv : options)
+        for (auto &kv : jobOptions)
             num = cupsAddOption(kv.first.c_str(),
                                 kv.second.c_str(),
                                 num,
@@ -221,7 +233,7 @@ int MacPrinter::PrintDirect(const std::string &printerName,
         int jobId = cupsPrintFile(
             printerName.c_str(),
             tmpName,
-            "Node Print Job",
+            title,
             num,
             cupOpts);
 
@@ -230,16 +242,28 @@ int MacPrinter::PrintDirect(const std::string &printerName,
 
         unlink(tmpName);
 
+        // cupsPrintFile uploads in one go: progress is all-or-nothing.
+        if (jobId > 0 && control.onProgress)
+            control.onProgress(data.size, data.size);
+
         return jobId > 0 ? jobId : 0;
     }
 
     // RAW / TEXT / COMMAND
+    cups_option_t *rawOpts = nullptr;
+    int numRaw = 0;
+    for (auto &kv : jobOptions)
+        numRaw = cupsAddOption(kv.first.c_str(), kv.second.c_str(), numRaw, &rawOpts);
+
     int jobId = cupsCreateJob(
         CUPS_HTTP_DEFAULT,
         printerName.c_str(),
-        "Node Print Job",
-        0,
-        NULL);
+        title,
+        numRaw,
+        rawOpts);
+
+    if (rawOpts)
+        cupsFreeOptions(numRaw, rawOpts);
 
     if (jobId <= 0)
         return 0;
@@ -248,7 +272,7 @@ int MacPrinter::PrintDirect(const std::string &printerName,
         CUPS_HTTP_DEFAULT,
         printerName.c_str(),
         jobId,
-        "Node Print Job",
+        title,
         CUPS_FORMAT_RAW,
         1);
 
@@ -258,13 +282,28 @@ int MacPrinter::PrintDirect(const std::string &printerName,
         return 0;
     }
 
-    if (cupsWriteRequestData(
-            CUPS_HTTP_DEFAULT,
-            (const char*)data.data(),
-            data.size()) != HTTP_STATUS_CONTINUE)
+    bool chunked = control.onProgress || control.cancelled;
+    size_t step = chunked ? kProgressChunkSize : std::max<size_t>(data.size, 1);
+    for (size_t off = 0; off < data.size; off += step)
     {
-        cupsCancelJob(printerName.c_str(), jobId);
-        return 0;
+        if (control.Cancelled())
+        {
+            cupsCancelJob(printerName.c_str(), jobId);
+            return 0;
+        }
+
+        size_t n = std::min(step, data.size - off);
+        if (cupsWriteRequestData(
+                CUPS_HTTP_DEFAULT,
+                (const char*)data.data + off,
+                n) != HTTP_STATUS_CONTINUE)
+        {
+            cupsCancelJob(printerName.c_str(), jobId);
+            return 0;
+        }
+
+        if (control.onProgress)
+            control.onProgress(off + n, data.size);
     }
 
     ipp_status_t fin =
@@ -279,14 +318,38 @@ int MacPrinter::PrintDirect(const std::string &printerName,
 }
 
 int MacPrinter::PrintFile(const std::string &printerName,
-                          const std::string &filename)
+                          const std::string &filename,
+                          const PrintControl &control)
 {
+    // cupsPrintFile cannot be interrupted: cancellation only applies
+    // before it starts.
+    if (control.Cancelled())
+        return 0;
+
+    const char *title = control.jobName.empty() ? "Node Print Job" : control.jobName.c_str();
+
+    cups_option_t *opts = nullptr;
+    int num = 0;
+    if (control.priority > 0)
+        num = cupsAddOption("job-priority", std::to_string(control.priority).c_str(), num, &opts);
+
     int jobId = cupsPrintFile(
         printerName.c_str(),
         filename.c_str(),
-        "Node Print Job",
-        0,
-        NULL);
+        title,
+        num,
+        opts);
+
+    if (opts)
+        cupsFreeOptions(num, opts);
+
+    // cupsPrintFile uploads in one go: progress is all-or-nothing.
+    if (jobId > 0 && control.onProgress)
+    {
+        std::ifstream f(filename, std::ios::binary | std::ios::ate);
+        uint64_t size = f ? (uint64_t)f.tellg() : 0;
+        control.onProgress(size, size);
+    }
 
     return jobId > 0 ? jobId : 0;
 }
@@ -295,6 +358,35 @@ int MacPrinter::PrintFile(const std::string &printerName,
    Job Management
 ========================================================= */
 
+static JobDetailsNative JobFromCups(const cups_job_t &job, const std::string &printerName)
+{
+    JobDetailsNative j;
+    j.id = job.id;
+    j.printerName = printerName.empty() && job.dest ? job.dest : printerName;
+    j.name = job.title ? job.title : "";
+    j.user = job.user ? job.user : "";
+    j.format = job.format ? job.format : "";
+    j.priority = job.priority;
+    j.size = job.size;
+
+    switch (job.state)
+    {
+        case IPP_JSTATE_PENDING:    j.status = { "PENDING" }; break;
+        case IPP_JSTATE_HELD:       j.status = { "PAUSED" }; break;
+        case IPP_JSTATE_PROCESSING: j.status = { "PRINTING" }; break;
+        case IPP_JSTATE_STOPPED:    j.status = { "STOPPED" }; break; // waiting on the printer, not final
+        case IPP_JSTATE_CANCELED:   j.status = { "CANCELLED" }; break;
+        case IPP_JSTATE_ABORTED:    j.status = { "ABORTED" }; break;
+        case IPP_JSTATE_COMPLETED:  j.status = { "PRINTED" }; break;
+        default:                    j.status = { "PENDING" }; break;
+    }
+
+    j.creationTime = job.creation_time;
+    j.processingTime = job.processing_time;
+    j.completedTime = job.completed_time;
+    return j;
+}
+
 JobDetailsNative MacPrinter::GetJob(const std::string &printerName, int jobId)
 {
     JobDetailsNative j;
@@ -307,33 +399,14 @@ JobDetailsNative MacPrinter::GetJob(const std::string &printerName, int jobId)
         printerName.c_str(),
         0,
         CUPS_WHICHJOBS_ALL);
+    if (num < 0)
+        LastQueryFailed() = true;
 
     for (int i = 0; i < num; i++)
     {
         if (jobs[i].id == jobId)
         {
-            j.name = jobs[i].title ? jobs[i].title : "";
-            j.user = jobs[i].user ? jobs[i].user : "";
-            j.format = jobs[i].format ? jobs[i].format : "";
-            j.priority = jobs[i].priority;
-            j.size = jobs[i].size;
-
-            switch (jobs[i].state)
-            {
-                case IPP_JSTATE_PENDING:    j.status = { "PENDING" }; break;
-                case IPP_JSTATE_HELD:       j.status = { "PAUSED" }; break;
-                case IPP_JSTATE_PROCESSING: j.status = { "PRINTING" }; break;
-                case IPP_JSTATE_STOPPED:    j.status = { "ABORTED" }; break;
-                case IPP_JSTATE_CANCELED:   j.status = { "CANCELLED" }; break;
-                case IPP_JSTATE_ABORTED:    j.status = { "ABORTED" }; break;
-                case IPP_JSTATE_COMPLETED:  j.status = { "PRINTED" }; break;
-                default:                    j.status = { "PENDING" }; break;
-            }
-
-            j.creationTime = jobs[i].creation_time;
-            j.processingTime = jobs[i].processing_time;
-            j.completedTime = jobs[i].completed_time;
-
+            j = JobFromCups(jobs[i], printerName);
             break;
         }
     }
@@ -342,6 +415,38 @@ JobDetailsNative MacPrinter::GetJob(const std::string &printerName, int jobId)
     return j;
 }
 
+std::vector<JobDetailsNative> MacPrinter::GetJobs(const std::string &printerName, const JobQueryNative &query)
+{
+    int which = query.which == JobWhich::Completed ? CUPS_WHICHJOBS_COMPLETED
+              : query.which == JobWhich::All       ? CUPS_WHICHJOBS_ALL
+                                                   : CUPS_WHICHJOBS_ACTIVE;
+
+    // cupsGetJobs has no limit or first id: filtered here
+    cups_job_t *jobs = nullptr;
+    int num = cupsGetJobs(
+        &jobs,
+        printerName.empty() ? NULL : printerName.c_str(),
+        0,
+        which);
+    if (num < 0)
+        LastQueryFailed() = true;
+
+    std::vector<JobDetailsNative> out;
+    for (int i = 0; i < num; i++)
+    {
+        JobDetailsNative j = JobFromCups(jobs[i], printerName);
+        if (query.Matches(j))
+            out.push_back(std::move(j));
+    }
+    cupsFreeJobs(num, jobs);
+
+    std::sort(out.begin(), out.end(),
+              [](const JobDetailsNative &a, const JobDetailsNative &b) { return a.id < b.id; });
+    if (query.limit > 0 && out.size() > (size_t)query.limit)
+        out.resize((size_t)query.limit);
+    return out;
+}
+
 void MacPrinter::SetJob(const std::string &printerName,
                         int jobId,
                         const std::string &command)
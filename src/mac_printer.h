@@ -14,16 +14,19 @@ public:
     std::string GetSelectedPaperSize(const std::string &printerName) override;
 
     int PrintDirect(const std::string &printerName,
-                    const std::vector<uint8_t> &data,
+                    ByteSpan data,
                     const std::string &type,
-                    const StringMap &options) override;
+                    const StringMap &options,
+                    const PrintControl &control) override;
 
     int PrintFile(const std::string &printerName,
-                  const std::string &filename) override;
+                  const std::string &filename,
+                  const PrintControl &control) override;
 
     std::vector<std::string> GetSupportedPrintFormats() override;
 
     JobDetailsNative GetJob(const std::string &printerName, int jobId) override;
+    std::vector<JobDetailsNative> GetJobs(const std::string &printerName, const JobQueryNative &query) override;
     void SetJob(const std::string &printerName, int jobId, const std::string &command) override;
     std::vector<std::string> GetSupportedJobCommands() override;
 };
@@ -2,44 +2,104 @@
 
 /* Forward declarations (implemented in print.cpp) */
 
+void InitPrinterService(Napi::Env env);
+
 Napi::Value getPrinters(const Napi::CallbackInfo &info);
 Napi::Value getPrinter(const Napi::CallbackInfo &info);
 Napi::Value getPrinterDriverOptions(const Napi::CallbackInfo &info);
 Napi::Value getSelectedPaperSize(const Napi::CallbackInfo &info);
+Napi::Value getPrinterSnapshot(const Napi::CallbackInfo &info);
 Napi::Value getDefaultPrinterName(const Napi::CallbackInfo &info);
+Napi::Value refreshPrinters(const Napi::CallbackInfo &info);
+Napi::Value setPrinterRegistryTtl(const Napi::CallbackInfo &info);
 
 Napi::Value printDirect(const Napi::CallbackInfo &info);
 Napi::Value printFile(const Napi::CallbackInfo &info);
+Napi::Value openPrintStream(const Napi::CallbackInfo &info);
+Napi::Value printBatch(const Napi::CallbackInfo &info);
+Napi::Value setPrintExecutorThreads(const Napi::CallbackInfo &info);
+Napi::Value setPrintQueueLimits(const Napi::CallbackInfo &info);
+Napi::Value getPrintQueueStats(const Napi::CallbackInfo &info);
+Napi::Value setPrintCoalescing(const Napi::CallbackInfo &info);
+Napi::Value setPrinterTimeouts(const Napi::CallbackInfo &info);
+Napi::Value setPrintRetryPolicy(const Napi::CallbackInfo &info);
 
 Napi::Value getSupportedPrintFormats(const Napi::CallbackInfo &info);
+Napi::Value getCapabilityCacheStats(const Napi::CallbackInfo &info);
+Napi::Value setCapabilityCacheLimits(const Napi::CallbackInfo &info);
 
 Napi::Value getJob(const Napi::CallbackInfo &info);
+Napi::Value getJobs(const Napi::CallbackInfo &info);
 Napi::Value setJob(const Napi::CallbackInfo &info);
 Napi::Value getSupportedJobCommands(const Napi::CallbackInfo &info);
+Napi::Value watch(const Napi::CallbackInfo &info);
+Napi::Value watchJob(const Napi::CallbackInfo &info);
+Napi::Value waitForJob(const Napi::CallbackInfo &info);
+
+Napi::Value getPrintersAsync(const Napi::CallbackInfo &info);
+Napi::Value getPrinterAsync(const Napi::CallbackInfo &info);
+Napi::Value getDefaultPrinterNameAsync(const Napi::CallbackInfo &info);
+Napi::Value getPrinterDriverOptionsAsync(const Napi::CallbackInfo &info);
+Napi::Value getSelectedPaperSizeAsync(const Napi::CallbackInfo &info);
+Napi::Value getPrinterSnapshotAsync(const Napi::CallbackInfo &info);
+Napi::Value getJobAsync(const Napi::CallbackInfo &info);
+Napi::Value getJobsAsync(const Napi::CallbackInfo &info);
+Napi::Value setJobAsync(const Napi::CallbackInfo &info);
 
 /* Module initialization */
 
 Napi::Object Init(Napi::Env env, Napi::Object exports)
 {
+    // Long-lived backend for this environment; shut down with it
+    InitPrinterService(env);
+
     // Printer listing
     exports.Set("getPrinters", Napi::Function::New(env, getPrinters));
     exports.Set("getPrinter", Napi::Function::New(env, getPrinter));
     exports.Set("getPrinterDriverOptions", Napi::Function::New(env, getPrinterDriverOptions));
     exports.Set("getSelectedPaperSize", Napi::Function::New(env, getSelectedPaperSize));
+    exports.Set("getPrinterSnapshot", Napi::Function::New(env, getPrinterSnapshot));
     exports.Set("getDefaultPrinterName", Napi::Function::New(env, getDefaultPrinterName));
+    exports.Set("refreshPrinters", Napi::Function::New(env, refreshPrinters));
+    exports.Set("setPrinterRegistryTtl", Napi::Function::New(env, setPrinterRegistryTtl));
 
     // Printing
     exports.Set("printDirect", Napi::Function::New(env, printDirect));
     exports.Set("printFile", Napi::Function::New(env, printFile));
+    exports.Set("openPrintStream", Napi::Function::New(env, openPrintStream));
+    exports.Set("printBatch", Napi::Function::New(env, printBatch));
+    exports.Set("setPrintExecutorThreads", Napi::Function::New(env, setPrintExecutorThreads));
+    exports.Set("setPrintQueueLimits", Napi::Function::New(env, setPrintQueueLimits));
+    exports.Set("getPrintQueueStats", Napi::Function::New(env, getPrintQueueStats));
+    exports.Set("setPrintCoalescing", Napi::Function::New(env, setPrintCoalescing));
+    exports.Set("setPrinterTimeouts", Napi::Function::New(env, setPrinterTimeouts));
+    exports.Set("setPrintRetryPolicy", Napi::Function::New(env, setPrintRetryPolicy));
 
     // Capabilities
     exports.Set("getSupportedPrintFormats", Napi::Function::New(env, getSupportedPrintFormats));
     exports.Set("getSupportedJobCommands", Napi::Function::New(env, getSupportedJobCommands));
+    exports.Set("watch", Napi::Function::New(env, watch));
+    exports.Set("watchJob", Napi::Function::New(env, watchJob));
+    exports.Set("waitForJob", Napi::Function::New(env, waitForJob));
+    exports.Set("getCapabilityCacheStats", Napi::Function::New(env, getCapabilityCacheStats));
+    exports.Set("setCapabilityCacheLimits", Napi::Function::New(env, setCapabilityCacheLimits));
 
     // Job management
     exports.Set("getJob", Napi::Function::New(env, getJob));
+    exports.Set("getJobs", Napi::Function::New(env, getJobs));
     exports.Set("setJob", Napi::Function::New(env, setJob));
 
+    // Promise-based queries (run off the JS thread)
+    exports.Set("getPrintersAsync", Napi::Function::New(env, getPrintersAsync));
+    exports.Set("getPrinterAsync", Napi::Function::New(env, getPrinterAsync));
+    exports.Set("getDefaultPrinterNameAsync", Napi::Function::New(env, getDefaultPrinterNameAsync));
+    exports.Set("getPrinterDriverOptionsAsync", Napi::Function::New(env, getPrinterDriverOptionsAsync));
+    exports.Set("getSelectedPaperSizeAsync", Napi::Function::New(env, getSelectedPaperSizeAsync));
+    exports.Set("getPrinterSnapshotAsync", Napi::Function::New(env, getPrinterSnapshotAsync));
+    exports.Set("getJobAsync", Napi::Function::New(env, getJobAsync));
+    exports.Set("getJobsAsync", Napi::Function::New(env, getJobsAsync));
+    exports.Set("setJobAsync", Napi::Function::New(env, setJobAsync));
+
     return exports;
 }
 
@@ -0,0 +1,277 @@
+#include "ppd_cache.h"
+
+#include <cups/cups.h>
+#include <cups/ppd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+/* =========================================================
+   Helpers
+========================================================= */
+
+static bool ParsePpd(const char *path, PpdCapabilities &out)
+{
+    ppd_file_t *ppd = ppdOpenFile(path);
+    if (!ppd)
+        return false;
+
+    ppdMarkDefaults(ppd);
+
+    for (ppd_option_t *opt = ppdFirstOption(ppd); opt; opt = ppdNextOption(ppd))
+    {
+        std::map<std::string, bool> choices;
+
+        for (int i = 0; i < opt->num_choices; i++)
+            choices[opt->choices[i].choice] =
+                strcmp(opt->defchoice, opt->choices[i].choice) == 0;
+
+        out.driverOptions[opt->keyword] = std::move(choices);
+    }
+
+    ppd_option_t *paper = ppdFindOption(ppd, "PageSize");
+    if (!paper)
+        paper = ppdFindOption(ppd, "PageRegion");
+
+    if (paper && paper->defchoice[0])
+        out.selectedPaperSize = paper->defchoice;
+
+    ppdClose(ppd);
+    return true;
+}
+
+// Rough heap footprint of a parsed entry; map nodes dominate.
+static size_t ApproxBytes(const PpdCapabilities &caps)
+{
+    const size_t nodeOverhead = 64;
+
+    size_t n = sizeof(PpdCapabilities) + caps.selectedPaperSize.size();
+    for (auto &group : caps.driverOptions)
+    {
+        n += nodeOverhead + group.first.size();
+        for (auto &choice : group.second)
+            n += nodeOverhead + choice.first.size();
+    }
+    return n;
+}
+
+/* =========================================================
+   PpdCache
+========================================================= */
+
+PpdCache::~PpdCache()
+{
+    Clear();
+}
+
+// Holds a printer's fetch slot for one Get; the last user removes it.
+class PpdCache::FetchGuard
+{
+public:
+    FetchGuard(PpdCache &cache, const std::string &printerName)
+        : cache(cache), printerName(printerName)
+    {
+        {
+            std::lock_guard<std::mutex> lock(cache.mu);
+            auto &s = cache.fetchLocks[printerName];
+            if (!s)
+                s.reset(new FetchSlot());
+            s->users++;
+            slot = s.get();
+        }
+        slot->mu.lock();
+    }
+
+    ~FetchGuard()
+    {
+        slot->mu.unlock();
+
+        std::lock_guard<std::mutex> lock(cache.mu);
+        if (--slot->users == 0)
+            cache.fetchLocks.erase(printerName);
+    }
+
+    FetchGuard(const FetchGuard &) = delete;
+    FetchGuard &operator=(const FetchGuard &) = delete;
+
+private:
+    PpdCache &cache;
+    const std::string &printerName;
+    FetchSlot *slot = nullptr;
+};
+
+std::shared_ptr<const PpdCapabilities> PpdCache::Get(const std::string &printerName)
+{
+    // One download per printer at a time: a conditional request that
+    // turns into a full download rewrites the cached local file.
+    FetchGuard fetchGuard(*this, printerName);
+
+    time_t modtime = 0;
+    std::string cachedPath;
+    std::shared_ptr<const PpdCapabilities> cached;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = index.find(printerName);
+        if (it != index.end())
+        {
+            modtime = it->second->modtime;
+            cachedPath = it->second->ppdPath;
+            cached = it->second->caps;
+        }
+    }
+
+    auto conn = pool.Acquire();
+    if (!conn)
+    {
+        if (cached)
+            LastTimeout() = TimeoutKind::None;
+        return cached;
+    }
+
+    char buffer[1024];
+    snprintf(buffer, sizeof(buffer), "%s", cachedPath.c_str());
+
+    http_status_t st = cupsGetPPD3(conn.get(),
+                                   printerName.c_str(),
+                                   &modtime,
+                                   buffer,
+                                   sizeof(buffer));
+
+    if (st == HTTP_STATUS_NOT_MODIFIED && cached)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        hits++;
+
+        auto it = index.find(printerName);
+        if (it != index.end())
+            lru.splice(lru.begin(), lru, it->second);
+
+        return cached;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        misses++;
+    }
+
+    if (st != HTTP_STATUS_OK)
+    {
+        // Server unreachable or busy: a stale answer beats none, and
+        // is not reported as a timeout.
+        if (cached && st != HTTP_STATUS_NOT_FOUND)
+        {
+            conn = CupsConnectionPool::Lease();
+            LastTimeout() = TimeoutKind::None;
+            return cached;
+        }
+
+        Erase(printerName);
+        return nullptr;
+    }
+
+    auto caps = std::make_shared<PpdCapabilities>();
+    if (!ParsePpd(buffer, *caps))
+    {
+        Erase(printerName);
+        if (cachedPath != buffer)
+            unlink(buffer);
+        return nullptr;
+    }
+
+    Entry entry;
+    entry.printerName = printerName;
+    entry.modtime = modtime;
+    entry.ppdPath = buffer;
+    entry.bytes = ApproxBytes(*caps);
+    entry.caps = caps;
+
+    Store(std::move(entry));
+    return caps;
+}
+
+void PpdCache::Store(Entry entry)
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto it = index.find(entry.printerName);
+    if (it != index.end())
+    {
+        if (it->second->ppdPath != entry.ppdPath)
+            unlink(it->second->ppdPath.c_str());
+        bytes -= it->second->bytes;
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    bytes += entry.bytes;
+    lru.push_front(std::move(entry));
+    index[lru.front().printerName] = lru.begin();
+
+    EvictLocked();
+}
+
+void PpdCache::Erase(const std::string &printerName)
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto it = index.find(printerName);
+    if (it == index.end())
+        return;
+
+    unlink(it->second->ppdPath.c_str());
+    bytes -= it->second->bytes;
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+void PpdCache::EvictLocked()
+{
+    // The newest entry survives a byte overflow on its own, otherwise a
+    // single oversized PPD would be re-downloaded on every call.
+    while (!lru.empty() &&
+           (lru.size() > maxEntries || (bytes > maxBytes && lru.size() > 1)))
+    {
+        Entry &victim = lru.back();
+        unlink(victim.ppdPath.c_str());
+        bytes -= victim.bytes;
+        index.erase(victim.printerName);
+        lru.pop_back();
+        evictions++;
+    }
+}
+
+void PpdCache::SetLimits(size_t entries, size_t byteLimit)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    maxEntries = entries;
+    maxBytes = byteLimit;
+    EvictLocked();
+}
+
+CacheStatsNative PpdCache::Stats()
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    CacheStatsNative s;
+    s.hits = hits;
+    s.misses = misses;
+    s.evictions = evictions;
+    s.entries = lru.size();
+    s.bytes = bytes;
+    s.maxEntries = maxEntries;
+    s.maxBytes = maxBytes;
+    return s;
+}
+
+void PpdCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    for (auto &e : lru)
+        unlink(e.ppdPath.c_str());
+
+    lru.clear();
+    index.clear();
+    bytes = 0;
+}
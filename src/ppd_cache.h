@@ -0,0 +1,84 @@
+#ifndef PPD_CACHE_H
+#define PPD_CACHE_H
+
+#include "printer_interface.h"
+#include "cups_connection_pool.h"
+
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Everything we read out of a PPD, parsed once.
+struct PpdCapabilities {
+    DriverOptions driverOptions;
+    std::string selectedPaperSize;
+};
+
+/*
+  Parsed-PPD cache keyed by printer name and PPD modification time.
+
+  Each lookup revalidates with a conditional cupsGetPPD3 request; the PPD
+  is only downloaded and parsed again when the server reports a change.
+  Memory is bounded by entry count and approximate parsed size, and the
+  least recently used entry is evicted first.
+*/
+class PpdCache
+{
+public:
+    explicit PpdCache(CupsConnectionPool &pool) : pool(pool) {}
+    ~PpdCache();
+
+    PpdCache(const PpdCache &) = delete;
+    PpdCache &operator=(const PpdCache &) = delete;
+
+    // nullptr when the printer has no PPD (raw / driverless queue).
+    std::shared_ptr<const PpdCapabilities> Get(const std::string &printerName);
+
+    void SetLimits(size_t maxEntries, size_t maxBytes);
+    CacheStatsNative Stats();
+    void Clear();
+
+private:
+    struct Entry {
+        std::string printerName;
+        time_t modtime = 0;
+        std::string ppdPath; // local copy (or symlink) kept for revalidation
+        std::shared_ptr<const PpdCapabilities> caps;
+        size_t bytes = 0;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    // Serializes fetches of one printer's PPD. Kept only while some Get
+    // holds or waits for it, so any name can be asked for.
+    struct FetchSlot {
+        std::mutex mu;
+        size_t users = 0;
+    };
+
+    class FetchGuard;
+
+    void Store(Entry entry);
+    void Erase(const std::string &printerName);
+    void EvictLocked();
+
+    CupsConnectionPool &pool;
+
+    std::mutex mu;
+    EntryList lru; // front = most recently used
+    std::unordered_map<std::string, EntryList::iterator> index;
+    std::unordered_map<std::string, std::unique_ptr<FetchSlot>> fetchLocks;
+
+    size_t maxEntries = 32;
+    size_t maxBytes = 4 * 1024 * 1024;
+    size_t bytes = 0;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+};
+
+#endif
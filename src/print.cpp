@@ -3,13 +3,49 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <chrono>
 
-#include "printer_factory.h"
 #include "printer_interface.h"
+#include "printer_service.h"
+#include "print_executor.h"
+#include "print_retry.h"
+#include "printer_watcher.h"
+#include "job_poller.h"
 
-static std::unique_ptr<PrinterInterface> P()
+/* =========================================================
+   Service
+   One PrinterService per environment, kept in the addon's
+   instance data and shut down with the environment.
+========================================================= */
+
+struct AddonData
+{
+    std::shared_ptr<PrinterService> service;
+
+    ~AddonData()
+    {
+        if (service)
+            service->Shutdown();
+    }
+};
+
+void InitPrinterService(Napi::Env env)
+{
+    auto data = new AddonData();
+    data->service = std::make_shared<PrinterService>();
+    data->service->Init();
+    env.SetInstanceData<AddonData>(data);
+}
+
+static std::shared_ptr<PrinterService> Service(Napi::Env env)
 {
-    return PrinterFactory::Create();
+    return env.GetInstanceData<AddonData>()->service;
 }
 
 /* =========================================================
@@ -43,29 +79,308 @@ static Napi::Object JsDriverOptions(Napi::Env env, const DriverOptions &opts)
     return out;
 }
 
-static Napi::Object JsJobDetails(Napi::Env env, const JobDetailsNative &j)
+// Only the JobField parts in `fields`; id, printerName and status always.
+static Napi::Object JsJobDetails(Napi::Env env, const JobDetailsNative &j, unsigned fields = JOB_ALL)
 {
     Napi::Object o = Napi::Object::New(env);
     o.Set("id", j.id);
-    o.Set("name", j.name);
     o.Set("printerName", j.printerName);
-    o.Set("user", j.user);
-    o.Set("format", j.format);
-    o.Set("priority", j.priority);
-    o.Set("size", j.size);
+    if (fields & JOB_NAME)
+        o.Set("name", j.name);
+    if (fields & JOB_USER)
+        o.Set("user", j.user);
+    if (fields & JOB_FORMAT)
+        o.Set("format", j.format);
+    if (fields & JOB_PRIORITY)
+        o.Set("priority", j.priority);
+    if (fields & JOB_SIZE)
+        o.Set("size", j.size);
 
     Napi::Array st = Napi::Array::New(env, j.status.size());
     for (size_t i = 0; i < j.status.size(); i++)
         st.Set((uint32_t)i, j.status[i]);
     o.Set("status", st);
 
-    o.Set("completedTime", Napi::Date::New(env, (double)j.completedTime * 1000.0));
-    o.Set("creationTime", Napi::Date::New(env, (double)j.creationTime * 1000.0));
-    o.Set("processingTime", Napi::Date::New(env, (double)j.processingTime * 1000.0));
+    if (fields & JOB_TIMES)
+    {
+        o.Set("completedTime", Napi::Date::New(env, (double)j.completedTime * 1000.0));
+        o.Set("creationTime", Napi::Date::New(env, (double)j.creationTime * 1000.0));
+        o.Set("processingTime", Napi::Date::New(env, (double)j.processingTime * 1000.0));
+    }
+
+    return o;
+}
+
+// A job list as parallel columns: numbers in typed arrays, states and
+// printers as indexes into small name tables, strings only when asked
+// for. Times are ms since the epoch, 0 when unset.
+static Napi::Object JsJobColumns(Napi::Env env, const std::vector<JobDetailsNative> &jobs, unsigned fields)
+{
+    size_t n = jobs.size();
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("count", Napi::Number::New(env, (double)n));
+
+    auto ids = Napi::Int32Array::New(env, n);
+    auto states = Napi::Uint8Array::New(env, n);
+    auto printers = Napi::Uint16Array::New(env, n);
+    std::vector<std::string> stateNames, printerNames;
+
+    // Tables stay tiny (a handful of states, one entry per queue)
+    auto index = [](std::vector<std::string> &table, const std::string &value) -> size_t
+    {
+        auto it = std::find(table.begin(), table.end(), value);
+        if (it != table.end())
+            return (size_t)(it - table.begin());
+        table.push_back(value);
+        return table.size() - 1;
+    };
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ids[i] = jobs[i].id;
+        states[i] = (uint8_t)index(stateNames, jobs[i].status.empty() ? "PENDING" : jobs[i].status[0]);
+        printers[i] = (uint16_t)index(printerNames, jobs[i].printerName);
+    }
+
+    auto names = [env](const std::vector<std::string> &table)
+    {
+        Napi::Array arr = Napi::Array::New(env, table.size());
+        for (size_t i = 0; i < table.size(); i++)
+            arr.Set((uint32_t)i, table[i]);
+        return arr;
+    };
+
+    o.Set("ids", ids);
+    o.Set("states", states);
+    o.Set("stateNames", names(stateNames));
+    o.Set("printers", printers);
+    o.Set("printerNames", names(printerNames));
+
+    auto strings = [env, &jobs, n](std::string JobDetailsNative::*field)
+    {
+        Napi::Array arr = Napi::Array::New(env, n);
+        for (size_t i = 0; i < n; i++)
+            arr.Set((uint32_t)i, jobs[i].*field);
+        return arr;
+    };
+    auto ints = [env, &jobs, n](int JobDetailsNative::*field)
+    {
+        auto arr = Napi::Int32Array::New(env, n);
+        for (size_t i = 0; i < n; i++)
+            arr[i] = jobs[i].*field;
+        return arr;
+    };
+    auto times = [env, &jobs, n](std::time_t JobDetailsNative::*field)
+    {
+        auto arr = Napi::Float64Array::New(env, n);
+        for (size_t i = 0; i < n; i++)
+            arr[i] = (double)(jobs[i].*field) * 1000.0;
+        return arr;
+    };
+
+    if (fields & JOB_NAME)
+        o.Set("names", strings(&JobDetailsNative::name));
+    if (fields & JOB_USER)
+        o.Set("users", strings(&JobDetailsNative::user));
+    if (fields & JOB_FORMAT)
+        o.Set("formats", strings(&JobDetailsNative::format));
+    if (fields & JOB_PRIORITY)
+        o.Set("priorities", ints(&JobDetailsNative::priority));
+    if (fields & JOB_SIZE)
+        o.Set("sizes", ints(&JobDetailsNative::size));
+    if (fields & JOB_TIMES)
+    {
+        o.Set("creationTimes", times(&JobDetailsNative::creationTime));
+        o.Set("processingTimes", times(&JobDetailsNative::processingTime));
+        o.Set("completedTimes", times(&JobDetailsNative::completedTime));
+    }
+
+    return o;
+}
+
+static Napi::Value JsJobList(Napi::Env env, const std::vector<JobDetailsNative> &jobs, unsigned fields, bool columnar)
+{
+    if (columnar)
+        return JsJobColumns(env, jobs, fields);
+
+    Napi::Array arr = Napi::Array::New(env, jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++)
+        arr.Set((uint32_t)i, JsJobDetails(env, jobs[i], fields));
+    return arr;
+}
+
+static Napi::Object JsPrinterEvent(Napi::Env env, const PrinterEventNative &e)
+{
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("event", e.event);
+    o.Set("printerName", e.printerName);
+    if (e.jobId > 0)
+        o.Set("jobId", e.jobId);
+
+    Napi::Array st = Napi::Array::New(env, e.status.size());
+    for (size_t i = 0; i < e.status.size(); i++)
+        st.Set((uint32_t)i, e.status[i]);
+    o.Set("status", st);
+
+    o.Set("message", e.message);
+    o.Set("time", Napi::Date::New(env, (double)e.time * 1000.0));
+    return o;
+}
+
+static Napi::Object JsPrinterSnapshot(Napi::Env env, const std::string &name, const PrinterSnapshotNative &s)
+{
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("name", name);
+
+    if (s.fields & SNAPSHOT_DETAILS)
+        o.Set("details", JsPrinterDetails(env, s.details));
+    if (s.fields & SNAPSHOT_DRIVER_OPTIONS)
+        o.Set("driverOptions", JsDriverOptions(env, s.driverOptions));
+    if (s.fields & SNAPSHOT_PAPER_SIZE)
+        o.Set("paperSize", s.paperSize);
 
     return o;
 }
 
+/* =========================================================
+   JS Parsers
+========================================================= */
+
+// opt[key] as { [k: string]: string }; values are stringified
+static StringMap ParseStringMap(Napi::Object opt, const char *key)
+{
+    StringMap out;
+    if (!opt.Has(key) || !opt.Get(key).IsObject())
+        return out;
+
+    Napi::Object o = opt.Get(key).As<Napi::Object>();
+    auto props = o.GetPropertyNames();
+    for (uint32_t i = 0; i < props.Length(); i++)
+    {
+        auto k = props.Get(i).As<Napi::String>().Utf8Value();
+        out[k] = o.Get(k).ToString().Utf8Value();
+    }
+    return out;
+}
+
+// { fields: ['details', 'driverOptions', 'paperSize'] }; missing = all
+static unsigned ParseSnapshotFields(Napi::Env env, const Napi::CallbackInfo &info, size_t index)
+{
+    if (info.Length() <= index || !info[index].IsObject())
+        return SNAPSHOT_ALL;
+
+    Napi::Object opt = info[index].As<Napi::Object>();
+    if (!opt.Has("fields") || !opt.Get("fields").IsArray())
+        return SNAPSHOT_ALL;
+
+    Napi::Array arr = opt.Get("fields").As<Napi::Array>();
+    unsigned fields = 0;
+    for (uint32_t i = 0; i < arr.Length(); i++)
+    {
+        auto f = arr.Get(i).ToString().Utf8Value();
+        if (f == "details")
+            fields |= SNAPSHOT_DETAILS;
+        else if (f == "driverOptions")
+            fields |= SNAPSHOT_DRIVER_OPTIONS;
+        else if (f == "paperSize")
+            fields |= SNAPSHOT_PAPER_SIZE;
+        else
+            Napi::TypeError::New(env, "unknown snapshot field: " + f).ThrowAsJavaScriptException();
+    }
+    return fields;
+}
+
+// { which, limit, firstJobId, user, attributes, columnar } at info[index]
+static JobQueryNative ParseJobQuery(Napi::Env env, const Napi::CallbackInfo &info, size_t index, bool &columnar)
+{
+    JobQueryNative q;
+    columnar = false;
+    if (info.Length() <= index || !info[index].IsObject())
+        return q;
+
+    Napi::Object opt = info[index].As<Napi::Object>();
+
+    if (opt.Has("which") && opt.Get("which").IsString())
+    {
+        std::string which = opt.Get("which").As<Napi::String>().Utf8Value();
+        if (which == "active")
+            q.which = JobWhich::Active;
+        else if (which == "completed")
+            q.which = JobWhich::Completed;
+        else if (which == "all")
+            q.which = JobWhich::All;
+        else
+            Napi::TypeError::New(env, "which must be 'active', 'completed' or 'all'").ThrowAsJavaScriptException();
+    }
+
+    if (opt.Has("limit") && opt.Get("limit").IsNumber())
+        q.limit = std::max(0, opt.Get("limit").As<Napi::Number>().Int32Value());
+    if (opt.Has("firstJobId") && opt.Get("firstJobId").IsNumber())
+        q.firstJobId = std::max(0, opt.Get("firstJobId").As<Napi::Number>().Int32Value());
+    if (opt.Has("user") && opt.Get("user").IsString())
+        q.user = opt.Get("user").As<Napi::String>().Utf8Value();
+    if (opt.Has("columnar") && opt.Get("columnar").IsBoolean())
+        columnar = opt.Get("columnar").As<Napi::Boolean>().Value();
+
+    if (opt.Has("attributes") && opt.Get("attributes").IsArray())
+    {
+        Napi::Array arr = opt.Get("attributes").As<Napi::Array>();
+        q.fields = 0;
+        for (uint32_t i = 0; i < arr.Length(); i++)
+        {
+            auto f = arr.Get(i).ToString().Utf8Value();
+            if (f == "name")
+                q.fields |= JOB_NAME;
+            else if (f == "user")
+                q.fields |= JOB_USER;
+            else if (f == "format")
+                q.fields |= JOB_FORMAT;
+            else if (f == "priority")
+                q.fields |= JOB_PRIORITY;
+            else if (f == "size")
+                q.fields |= JOB_SIZE;
+            else if (f == "times")
+                q.fields |= JOB_TIMES;
+            else
+                Napi::TypeError::New(env, "unknown job attribute: " + f).ThrowAsJavaScriptException();
+        }
+    }
+
+    return q;
+}
+
+/* =========================================================
+   Registry helpers
+========================================================= */
+
+static PrinterDetailsNative LookupPrinter(PrinterService &service, const std::string &name)
+{
+    PrinterDetailsNative p;
+    if (service.Registry().FindPrinter(service.Backend(), name, p))
+        return p;
+
+    // Not in the snapshot (yet): ask the backend for this one printer only.
+    return service.Backend().GetPrinter(name);
+}
+
+// Details come from the registry; the backend only opens the PPD once.
+static PrinterSnapshotNative BuildSnapshot(PrinterService &service, const std::string &name, unsigned fields)
+{
+    PrinterSnapshotNative s;
+
+    unsigned backendFields = fields & ~(unsigned)SNAPSHOT_DETAILS;
+    if (backendFields)
+        s = service.Backend().GetPrinterSnapshot(name, backendFields);
+
+    if (fields & SNAPSHOT_DETAILS)
+    {
+        s.details = LookupPrinter(service, name);
+        s.fields |= SNAPSHOT_DETAILS;
+    }
+
+    return s;
+}
+
 /* =========================================================
    Sync Methods
 ========================================================= */
@@ -73,8 +388,8 @@ static Napi::Object JsJobDetails(Napi::Env env, const JobDetailsNative &j)
 Napi::Value getPrinters(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
-    auto printer = P();
-    auto list = printer->GetPrinters();
+    auto service = Service(env);
+    auto list = service->Registry().GetPrinters(service->Backend());
 
     Napi::Array arr = Napi::Array::New(env, list.size());
     for (size_t i = 0; i < list.size(); i++)
@@ -89,8 +404,8 @@ Napi::Value getPrinter(const Napi::CallbackInfo &info)
     if (info.Length() < 1 || !info[0].IsString())
         Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
 
-    auto printer = P();
-    auto p = printer->GetPrinter(info[0].As<Napi::String>().Utf8Value());
+    auto service = Service(env);
+    auto p = LookupPrinter(*service, info[0].As<Napi::String>().Utf8Value());
     return JsPrinterDetails(env, p);
 }
 
@@ -100,8 +415,8 @@ Napi::Value getPrinterDriverOptions(const Napi::CallbackInfo &info)
     if (info.Length() < 1 || !info[0].IsString())
         Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
 
-    auto printer = P();
-    auto opts = printer->GetPrinterDriverOptions(info[0].As<Napi::String>().Utf8Value());
+    auto service = Service(env);
+    auto opts = service->Backend().GetPrinterDriverOptions(info[0].As<Napi::String>().Utf8Value());
     return JsDriverOptions(env, opts);
 }
 
@@ -111,26 +426,61 @@ Napi::Value getSelectedPaperSize(const Napi::CallbackInfo &info)
     if (info.Length() < 1 || !info[0].IsString())
         Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
 
-    auto printer = P();
-    auto ps = printer->GetSelectedPaperSize(info[0].As<Napi::String>().Utf8Value());
+    auto service = Service(env);
+    auto ps = service->Backend().GetSelectedPaperSize(info[0].As<Napi::String>().Utf8Value());
     return Napi::String::New(env, ps);
 }
 
+Napi::Value getPrinterSnapshot(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "getPrinterSnapshot(printerName, { fields })").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    unsigned fields = ParseSnapshotFields(env, info, 1);
+
+    auto service = Service(env);
+    return JsPrinterSnapshot(env, name, BuildSnapshot(*service, name, fields));
+}
+
 Napi::Value getDefaultPrinterName(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
-    auto printer = P();
-    auto name = printer->GetDefaultPrinterName();
+    auto service = Service(env);
+    auto name = service->Registry().GetDefaultPrinterName(service->Backend());
     if (name.empty())
         return env.Undefined();
     return Napi::String::New(env, name);
 }
 
+Napi::Value refreshPrinters(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    auto service = Service(env);
+    service->Registry().Refresh(service->Backend());
+    return env.Undefined();
+}
+
+Napi::Value setPrinterRegistryTtl(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber())
+        Napi::TypeError::New(env, "setPrinterRegistryTtl(ttlMs)").ThrowAsJavaScriptException();
+
+    int64_t ttlMs = info[0].As<Napi::Number>().Int64Value();
+    if (ttlMs < 0)
+        ttlMs = 0;
+
+    Service(env)->Registry().SetTtl(std::chrono::milliseconds(ttlMs));
+    return env.Undefined();
+}
+
 Napi::Value getSupportedPrintFormats(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
-    auto printer = P();
-    auto formats = printer->GetSupportedPrintFormats();
+    auto service = Service(env);
+    auto formats = service->Backend().GetSupportedPrintFormats();
 
     Napi::Array arr = Napi::Array::New(env, formats.size());
     for (size_t i = 0; i < formats.size(); i++)
@@ -142,8 +492,8 @@ Napi::Value getSupportedPrintFormats(const Napi::CallbackInfo &info)
 Napi::Value getSupportedJobCommands(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
-    auto printer = P();
-    auto cmds = printer->GetSupportedJobCommands();
+    auto service = Service(env);
+    auto cmds = service->Backend().GetSupportedJobCommands();
 
     Napi::Array arr = Napi::Array::New(env, cmds.size());
     for (size_t i = 0; i < cmds.size(); i++)
@@ -158,22 +508,39 @@ Napi::Value getJob(const Napi::CallbackInfo &info)
     if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber())
         Napi::TypeError::New(env, "getJob(printerName, jobId)").ThrowAsJavaScriptException();
 
-    auto printer = P();
-    auto job = printer->GetJob(
+    auto service = Service(env);
+    auto job = service->Backend().GetJob(
         info[0].As<Napi::String>().Utf8Value(),
         info[1].As<Napi::Number>().Int32Value());
 
     return JsJobDetails(env, job);
 }
 
+// getJobs(printerName, { which, limit, firstJobId, user, attributes, columnar });
+// '' lists every printer.
+Napi::Value getJobs(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "getJobs(printerName, options)").ThrowAsJavaScriptException();
+
+    bool columnar = false;
+    JobQueryNative query = ParseJobQuery(env, info, 1, columnar);
+
+    auto service = Service(env);
+    auto jobs = service->Backend().GetJobs(info[0].As<Napi::String>().Utf8Value(), query);
+
+    return JsJobList(env, jobs, query.fields, columnar);
+}
+
 Napi::Value setJob(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
     if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsString())
         Napi::TypeError::New(env, "setJob(printerName, jobId, command)").ThrowAsJavaScriptException();
 
-    auto printer = P();
-    printer->SetJob(
+    auto service = Service(env);
+    service->Backend().SetJob(
         info[0].As<Napi::String>().Utf8Value(),
         info[1].As<Napi::Number>().Int32Value(),
         info[2].As<Napi::String>().Utf8Value());
@@ -181,173 +548,2177 @@ Napi::Value setJob(const Napi::CallbackInfo &info)
     return env.Undefined();
 }
 
-/* =========================================================
-   Async Print Worker
-========================================================= */
+Napi::Value getCapabilityCacheStats(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    auto service = Service(env);
+    auto st = service->Backend().GetCapabilityCacheStats();
 
-class PrintWorker : public Napi::AsyncWorker
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("hits", Napi::Number::New(env, (double)st.hits));
+    o.Set("misses", Napi::Number::New(env, (double)st.misses));
+    o.Set("evictions", Napi::Number::New(env, (double)st.evictions));
+    o.Set("entries", Napi::Number::New(env, (double)st.entries));
+    o.Set("bytes", Napi::Number::New(env, (double)st.bytes));
+    o.Set("maxEntries", Napi::Number::New(env, (double)st.maxEntries));
+    o.Set("maxBytes", Napi::Number::New(env, (double)st.maxBytes));
+    return o;
+}
+
+Napi::Value setCapabilityCacheLimits(const Napi::CallbackInfo &info)
 {
-public:
-    PrintWorker(
-        Napi::Function successCb,
-        Napi::Function errorCb,
-        std::function<int()> workFn)
-        : Napi::AsyncWorker(successCb),
-          successRef(Napi::Persistent(successCb)),
-          errorRef(Napi::Persistent(errorCb)),
-          work(workFn)
-    {}
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "setCapabilityCacheLimits({ maxEntries, maxBytes })").ThrowAsJavaScriptException();
 
-    void Execute() override
-    {
-        try
-        {
-            jobId = work();
-            if (jobId <= 0)
-                SetError("Print failed");
-        }
-        catch (...)
-        {
-            SetError("Print failed (exception)");
-        }
-    }
+    Napi::Object opt = info[0].As<Napi::Object>();
+    auto service = Service(env);
+    auto current = service->Backend().GetCapabilityCacheStats();
 
-    void OnOK() override
-    {
-        Napi::HandleScope scope(Env());
-        successRef.Call({ Napi::String::New(Env(), std::to_string(jobId)) });
-    }
+    size_t maxEntries = current.maxEntries;
+    if (opt.Has("maxEntries") && opt.Get("maxEntries").IsNumber())
+        maxEntries = (size_t)std::max<int64_t>(0, opt.Get("maxEntries").As<Napi::Number>().Int64Value());
 
-    void OnError(const Napi::Error &e) override
-    {
-        Napi::HandleScope scope(Env());
-        errorRef.Call({ e.Value() });
-    }
+    size_t maxBytes = current.maxBytes;
+    if (opt.Has("maxBytes") && opt.Get("maxBytes").IsNumber())
+        maxBytes = (size_t)std::max<int64_t>(0, opt.Get("maxBytes").As<Napi::Number>().Int64Value());
 
-private:
-    Napi::FunctionReference successRef;
-    Napi::FunctionReference errorRef;
-    std::function<int()> work;
-    int jobId = 0;
-};
+    service->Backend().SetCapabilityCacheLimits(maxEntries, maxBytes);
+    return env.Undefined();
+}
 
-static Napi::Function SafeCb(Napi::Env env, Napi::Object opt, const char *key)
+Napi::Value setPrintExecutorThreads(const Napi::CallbackInfo &info)
 {
-    if (opt.Has(key) && opt.Get(key).IsFunction())
-        return opt.Get(key).As<Napi::Function>();
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsNumber())
+        Napi::TypeError::New(env, "setPrintExecutorThreads(threads)").ThrowAsJavaScriptException();
 
-    return Napi::Function::New(env, [](const Napi::CallbackInfo &) {});
+    int64_t threads = info[0].As<Napi::Number>().Int64Value();
+    Service(env)->Executor().SetThreadCount((size_t)std::max<int64_t>(1, threads));
+    return env.Undefined();
 }
 
-/* =========================================================
-   printDirect
-========================================================= */
-
-Napi::Value printDirect(const Napi::CallbackInfo &info)
+Napi::Value setPrintQueueLimits(const Napi::CallbackInfo &info)
 {
     auto env = info.Env();
-
     if (info.Length() < 1 || !info[0].IsObject())
-        Napi::TypeError::New(env, "options object required").ThrowAsJavaScriptException();
+        Napi::TypeError::New(env, "setPrintQueueLimits({ maxJobs, maxBytes, maxJobsPerPrinter, maxBytesPerPrinter })").ThrowAsJavaScriptException();
 
     Napi::Object opt = info[0].As<Napi::Object>();
+    auto service = Service(env);
+    PrintQueueLimits limits = service->Executor().Stats().limits;
 
-    if (!opt.Has("data"))
-        Napi::TypeError::New(env, "options.data required").ThrowAsJavaScriptException();
+    auto read = [&opt](const char *key, size_t &out)
+    {
+        if (opt.Has(key) && opt.Get(key).IsNumber())
+            out = (size_t)std::max<int64_t>(0, opt.Get(key).As<Napi::Number>().Int64Value());
+    };
+    read("maxJobs", limits.maxJobs);
+    read("maxBytes", limits.maxBytes);
+    read("maxJobsPerPrinter", limits.maxJobsPerPrinter);
+    read("maxBytesPerPrinter", limits.maxBytesPerPrinter);
+
+    service->Executor().SetLimits(limits);
+    return env.Undefined();
+}
 
-    std::string printerName;
-    if (opt.Has("printer") && opt.Get("printer").IsString())
-        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+Napi::Value getPrintQueueStats(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    auto st = Service(env)->Executor().Stats();
 
-    std::string type = "RAW";
-    if (opt.Has("type") && opt.Get("type").IsString())
-        type = opt.Get("type").As<Napi::String>().Utf8Value();
+    Napi::Object limits = Napi::Object::New(env);
+    limits.Set("maxJobs", Napi::Number::New(env, (double)st.limits.maxJobs));
+    limits.Set("maxBytes", Napi::Number::New(env, (double)st.limits.maxBytes));
+    limits.Set("maxJobsPerPrinter", Napi::Number::New(env, (double)st.limits.maxJobsPerPrinter));
+    limits.Set("maxBytesPerPrinter", Napi::Number::New(env, (double)st.limits.maxBytesPerPrinter));
 
-    StringMap driverOpts;
-    if (opt.Has("options") && opt.Get("options").IsObject())
+    Napi::Object printers = Napi::Object::New(env);
+    for (auto &p : st.printers)
     {
-        Napi::Object o = opt.Get("options").As<Napi::Object>();
-        auto props = o.GetPropertyNames();
-        for (uint32_t i = 0; i < props.Length(); i++)
-        {
-            auto k = props.Get(i).As<Napi::String>().Utf8Value();
-            auto v = o.Get(k).ToString().Utf8Value();
-            driverOpts[k] = v;
-        }
+        Napi::Object q = Napi::Object::New(env);
+        q.Set("jobs", Napi::Number::New(env, (double)p.jobs));
+        q.Set("bytes", Napi::Number::New(env, (double)p.bytes));
+        q.Set("waiting", Napi::Number::New(env, (double)p.waiting));
+        printers.Set(p.name, q);
     }
 
-    std::vector<uint8_t> data;
-    auto d = opt.Get("data");
+    Napi::Object latency = Napi::Object::New(env);
+    for (auto &kv : st.waitLatency)
+    {
+        Napi::Object l = Napi::Object::New(env);
+        l.Set("count", Napi::Number::New(env, (double)kv.second.count));
+        l.Set("meanMs", Napi::Number::New(env, kv.second.count ? kv.second.totalMs / kv.second.count : 0));
+        l.Set("maxMs", Napi::Number::New(env, kv.second.maxMs));
+        latency.Set(std::to_string(kv.first), l);
+    }
 
-    if (d.IsBuffer())
+    Napi::Object o = Napi::Object::New(env);
+    o.Set("jobs", Napi::Number::New(env, (double)st.jobs));
+    o.Set("running", Napi::Number::New(env, (double)st.running));
+    o.Set("bytes", Napi::Number::New(env, (double)st.bytes));
+    o.Set("waiting", Napi::Number::New(env, (double)st.waiting));
+    o.Set("rejected", Napi::Number::New(env, (double)st.rejected));
+    o.Set("expired", Napi::Number::New(env, (double)st.expired));
+    o.Set("cancelled", Napi::Number::New(env, (double)st.cancelled));
+    o.Set("limits", limits);
+    o.Set("printers", printers);
+    o.Set("waitLatency", latency);
+    return o;
+}
+
+// false / true, or { enabled, windowMs, maxJobs, maxBytes, maxDocumentBytes }
+// merged with the current settings; an object enables unless enabled: false.
+Napi::Value setPrintCoalescing(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !(info[0].IsBoolean() || info[0].IsObject()))
+        Napi::TypeError::New(env, "setPrintCoalescing(enabled | { windowMs, maxJobs, maxBytes, maxDocumentBytes })").ThrowAsJavaScriptException();
+
+    auto service = Service(env);
+    CoalescingConfig config = service->Coalescer().Config();
+
+    if (info[0].IsBoolean())
     {
-        auto b = d.As<Napi::Buffer<uint8_t>>();
-        data.assign(b.Data(), b.Data() + b.Length());
+        config.enabled = info[0].As<Napi::Boolean>().Value();
     }
     else
     {
-        auto s = d.ToString().Utf8Value();
-        data.assign(s.begin(), s.end());
+        Napi::Object opt = info[0].As<Napi::Object>();
+        auto read = [&opt](const char *key, size_t &out)
+        {
+            if (opt.Has(key) && opt.Get(key).IsNumber())
+                out = (size_t)std::max<int64_t>(0, opt.Get(key).As<Napi::Number>().Int64Value());
+        };
+
+        size_t windowMs = (size_t)config.window.count();
+        read("windowMs", windowMs);
+        read("maxJobs", config.maxJobs);
+        read("maxBytes", config.maxBytes);
+        read("maxDocumentBytes", config.maxDocumentBytes);
+        config.window = std::chrono::milliseconds(windowMs);
+
+        config.enabled = !(opt.Has("enabled") && opt.Get("enabled").IsBoolean() &&
+                           !opt.Get("enabled").As<Napi::Boolean>().Value());
     }
 
-    auto successCb = SafeCb(env, opt, "success");
-    auto errorCb = SafeCb(env, opt, "error");
+    service->Coalescer().Configure(config);
+    return env.Undefined();
+}
 
-    auto worker = new PrintWorker(
-        successCb,
-        errorCb,
-        [printerName, data, type, driverOpts]() -> int
-        {
-            auto printer = P();
-            std::string usePrinter = printerName.empty()
-                ? printer->GetDefaultPrinterName()
-                : printerName;
+// { retries, baseDelayMs, maxDelayMs, jitter } merged with the current
+// policy; applies to printDirect / printFile jobs submitted afterwards.
+Napi::Value setPrintRetryPolicy(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "setPrintRetryPolicy({ retries, baseDelayMs, maxDelayMs, jitter })").ThrowAsJavaScriptException();
 
-            return printer->PrintDirect(usePrinter, data, type, driverOpts);
-        });
+    auto service = Service(env);
+    RetryPolicy policy = service->GetRetryPolicy();
+    Napi::Object opt = info[0].As<Napi::Object>();
 
-    worker->Queue();
+    auto read = [&opt](const char *key, int64_t &out)
+    {
+        if (opt.Has(key) && opt.Get(key).IsNumber())
+            out = std::max<int64_t>(0, opt.Get(key).As<Napi::Number>().Int64Value());
+    };
+
+    int64_t retries = policy.retries, baseDelayMs = policy.baseDelayMs, maxDelayMs = policy.maxDelayMs;
+    read("retries", retries);
+    read("baseDelayMs", baseDelayMs);
+    read("maxDelayMs", maxDelayMs);
+    policy.retries = (unsigned)std::min<int64_t>(retries, 100);
+    policy.baseDelayMs = (uint32_t)std::min<int64_t>(baseDelayMs, UINT32_MAX);
+    policy.maxDelayMs = (uint32_t)std::min<int64_t>(maxDelayMs, UINT32_MAX);
+
+    if (opt.Has("jitter") && opt.Get("jitter").IsNumber())
+        policy.jitter = std::min(std::max(opt.Get("jitter").As<Napi::Number>().DoubleValue(), 0.0), 1.0);
+
+    service->SetRetryPolicy(policy);
     return env.Undefined();
 }
 
 /* =========================================================
-   printFile
+   Timeouts
+   Backends report a call that ran out of time through
+   LastTimeout(); it surfaces as an Error with code ETIMEDOUT
+   and `timeout` naming the limit: connect, read or total.
 ========================================================= */
 
-Napi::Value printFile(const Napi::CallbackInfo &info)
+static const char *TimeoutName(TimeoutKind kind)
 {
-    auto env = info.Env();
+    switch (kind)
+    {
+    case TimeoutKind::Connect:
+        return "connect";
+    case TimeoutKind::Read:
+        return "read";
+    case TimeoutKind::Total:
+        return "total";
+    default:
+        return "";
+    }
+}
 
-    if (info.Length() < 1 || !info[0].IsObject())
-        Napi::TypeError::New(env, "options object required").ThrowAsJavaScriptException();
+static std::string TimeoutMessage(const std::string &what, TimeoutKind kind)
+{
+    return what + " timed out (" + TimeoutName(kind) + ")";
+}
 
-    Napi::Object opt = info[0].As<Napi::Object>();
+static void SetTimeoutFields(Napi::Env env, const Napi::Error &err, TimeoutKind kind)
+{
+    err.Set("code", Napi::String::New(env, "ETIMEDOUT"));
+    err.Set("timeout", Napi::String::New(env, TimeoutName(kind)));
+}
 
-    if (!opt.Has("filename") || !opt.Get("filename").IsString())
-        Napi::TypeError::New(env, "options.filename required").ThrowAsJavaScriptException();
+// { connectMs, readMs, totalMs } on top of `base`
+static CallTimeouts ParseCallTimeouts(Napi::Object opt, CallTimeouts base)
+{
+    auto read = [&opt](const char *key, uint32_t &out)
+    {
+        if (opt.Has(key) && opt.Get(key).IsNumber())
+            out = (uint32_t)std::max<int64_t>(0, opt.Get(key).As<Napi::Number>().Int64Value());
+    };
+    read("connectMs", base.connectMs);
+    read("readMs", base.readMs);
+    read("totalMs", base.totalMs);
+    return base;
+}
 
-    std::string filename = opt.Get("filename").As<Napi::String>().Utf8Value();
+Napi::Value setPrinterTimeouts(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "setPrinterTimeouts({ connectMs, readMs, totalMs })").ThrowAsJavaScriptException();
 
-    std::string printerName;
-    if (opt.Has("printer") && opt.Get("printer").IsString())
-        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+    auto service = Service(env);
+    service->Backend().SetTimeouts(ParseCallTimeouts(info[0].As<Napi::Object>(), service->Backend().GetTimeouts()));
+    return env.Undefined();
+}
 
-    auto successCb = SafeCb(env, opt, "success");
-    auto errorCb = SafeCb(env, opt, "error");
+/* =========================================================
+   Async Query Worker
+   Runs the backend call on the threadpool and only touches
+   JS values in OnOK / OnError.
+========================================================= */
 
-    auto worker = new PrintWorker(
-        successCb,
-        errorCb,
-        [printerName, filename]() -> int
-        {
-            auto printer = P();
-            std::string usePrinter = printerName.empty()
-                ? printer->GetDefaultPrinterName()
-                : printerName;
+template <typename T>
+class QueryWorker : public Napi::AsyncWorker
+{
+public:
+    using WorkFn = std::function<T()>;
+    using ConvertFn = std::function<Napi::Value(Napi::Env, const T &)>;
+
+    QueryWorker(Napi::Env env, WorkFn workFn, ConvertFn convertFn)
+        : Napi::AsyncWorker(env),
+          deferred(Napi::Promise::Deferred::New(env)),
+          work(std::move(workFn)),
+          convert(std::move(convertFn))
+    {}
 
-            return printer->PrintFile(usePrinter, filename);
-        });
+    Napi::Promise Promise() const { return deferred.Promise(); }
 
-    worker->Queue();
-    return env.Undefined();
-}
\ No newline at end of file
+    void Execute() override
+    {
+        LastTimeout() = TimeoutKind::None;
+        try
+        {
+            result = work();
+            timeout = LastTimeout();
+            if (timeout != TimeoutKind::None)
+                SetError(TimeoutMessage("Query", timeout));
+        }
+        catch (const std::exception &e)
+        {
+            SetError(e.what());
+        }
+        catch (...)
+        {
+            SetError("Query failed (exception)");
+        }
+    }
+
+    void OnOK() override
+    {
+        Napi::HandleScope scope(Env());
+        deferred.Resolve(convert(Env(), result));
+    }
+
+    void OnError(const Napi::Error &e) override
+    {
+        Napi::HandleScope scope(Env());
+        if (timeout != TimeoutKind::None)
+            SetTimeoutFields(Env(), e, timeout);
+        deferred.Reject(e.Value());
+    }
+
+private:
+    Napi::Promise::Deferred deferred;
+    WorkFn work;
+    ConvertFn convert;
+    T result{};
+    TimeoutKind timeout = TimeoutKind::None;
+};
+
+template <typename T>
+static Napi::Value QueueQuery(
+    Napi::Env env,
+    typename QueryWorker<T>::WorkFn work,
+    typename QueryWorker<T>::ConvertFn convert)
+{
+    auto worker = new QueryWorker<T>(env, std::move(work), std::move(convert));
+    auto promise = worker->Promise();
+    worker->Queue();
+    return promise;
+}
+
+/* =========================================================
+   Async Methods
+========================================================= */
+
+Napi::Value getPrintersAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    auto service = Service(env);
+
+    return QueueQuery<std::vector<PrinterDetailsNative>>(
+        env,
+        [service]()
+        {
+            return service->Registry().GetPrinters(service->Backend());
+        },
+        [](Napi::Env env, const std::vector<PrinterDetailsNative> &list) -> Napi::Value
+        {
+            Napi::Array arr = Napi::Array::New(env, list.size());
+            for (size_t i = 0; i < list.size(); i++)
+                arr.Set((uint32_t)i, JsPrinterDetails(env, list[i]));
+            return arr;
+        });
+}
+
+Napi::Value getPrinterAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+
+    auto service = Service(env);
+    return QueueQuery<PrinterDetailsNative>(
+        env,
+        [service, name]()
+        {
+            return LookupPrinter(*service, name);
+        },
+        [](Napi::Env env, const PrinterDetailsNative &p) -> Napi::Value
+        {
+            return JsPrinterDetails(env, p);
+        });
+}
+
+Napi::Value getDefaultPrinterNameAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    auto service = Service(env);
+
+    return QueueQuery<std::string>(
+        env,
+        [service]()
+        {
+            return service->Registry().GetDefaultPrinterName(service->Backend());
+        },
+        [](Napi::Env env, const std::string &name) -> Napi::Value
+        {
+            if (name.empty())
+                return env.Undefined();
+            return Napi::String::New(env, name);
+        });
+}
+
+Napi::Value getPrinterDriverOptionsAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+
+    auto service = Service(env);
+    return QueueQuery<DriverOptions>(
+        env,
+        [service, name]()
+        {
+            return service->Backend().GetPrinterDriverOptions(name);
+        },
+        [](Napi::Env env, const DriverOptions &opts) -> Napi::Value
+        {
+            return JsDriverOptions(env, opts);
+        });
+}
+
+Napi::Value getSelectedPaperSizeAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "printerName required").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+
+    auto service = Service(env);
+    return QueueQuery<std::string>(
+        env,
+        [service, name]()
+        {
+            return service->Backend().GetSelectedPaperSize(name);
+        },
+        [](Napi::Env env, const std::string &ps) -> Napi::Value
+        {
+            return Napi::String::New(env, ps);
+        });
+}
+
+Napi::Value getPrinterSnapshotAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "getPrinterSnapshotAsync(printerName, { fields })").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    unsigned fields = ParseSnapshotFields(env, info, 1);
+
+    auto service = Service(env);
+    return QueueQuery<PrinterSnapshotNative>(
+        env,
+        [service, name, fields]()
+        {
+            return BuildSnapshot(*service, name, fields);
+        },
+        [name](Napi::Env env, const PrinterSnapshotNative &snapshot) -> Napi::Value
+        {
+            return JsPrinterSnapshot(env, name, snapshot);
+        });
+}
+
+Napi::Value getJobAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber())
+        Napi::TypeError::New(env, "getJobAsync(printerName, jobId)").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    int jobId = info[1].As<Napi::Number>().Int32Value();
+
+    auto service = Service(env);
+    return QueueQuery<JobDetailsNative>(
+        env,
+        [service, name, jobId]()
+        {
+            return service->Backend().GetJob(name, jobId);
+        },
+        [](Napi::Env env, const JobDetailsNative &job) -> Napi::Value
+        {
+            return JsJobDetails(env, job);
+        });
+}
+
+Napi::Value getJobsAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 1 || !info[0].IsString())
+        Napi::TypeError::New(env, "getJobsAsync(printerName, options)").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    bool columnar = false;
+    JobQueryNative query = ParseJobQuery(env, info, 1, columnar);
+
+    auto service = Service(env);
+    return QueueQuery<std::vector<JobDetailsNative>>(
+        env,
+        [service, name, query]()
+        {
+            return service->Backend().GetJobs(name, query);
+        },
+        [query, columnar](Napi::Env env, const std::vector<JobDetailsNative> &jobs) -> Napi::Value
+        {
+            return JsJobList(env, jobs, query.fields, columnar);
+        });
+}
+
+Napi::Value setJobAsync(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsString())
+        Napi::TypeError::New(env, "setJobAsync(printerName, jobId, command)").ThrowAsJavaScriptException();
+
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    int jobId = info[1].As<Napi::Number>().Int32Value();
+    std::string command = info[2].As<Napi::String>().Utf8Value();
+
+    auto service = Service(env);
+    return QueueQuery<bool>(
+        env,
+        [service, name, jobId, command]()
+        {
+            service->Backend().SetJob(name, jobId, command);
+            return true;
+        },
+        [](Napi::Env env, const bool &) -> Napi::Value
+        {
+            return env.Undefined();
+        });
+}
+
+/* =========================================================
+   Watch
+   One backend subscription shared by every listener
+   (PrinterWatcher); events reach JS through each listener's
+   ThreadSafeFunction.
+========================================================= */
+
+struct WatchCallbacks
+{
+    Napi::FunctionReference callback;
+    Napi::FunctionReference onError;
+    std::atomic<bool> closed{false};
+};
+
+class JsWatchListener : public PrinterWatchListener
+{
+public:
+    JsWatchListener(Napi::Env env, Napi::Function callback, Napi::Function onError)
+        : callbacks(new WatchCallbacks())
+    {
+        callbacks->callback = Napi::Persistent(callback);
+        if (!onError.IsEmpty())
+            callbacks->onError = Napi::Persistent(onError);
+
+        tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo &) {}),
+            "electronPrinterWatch",
+            0,
+            1,
+            callbacks,
+            [](Napi::Env, WatchCallbacks *cb) { delete cb; });
+    }
+
+    ~JsWatchListener() override
+    {
+        tsfn.Release();
+    }
+
+    // After unsubscribe nothing more reaches JS, even calls already queued
+    void Close()
+    {
+        callbacks->closed = true;
+    }
+
+    void OnEvents(const std::vector<PrinterEventNative> &events) override
+    {
+        if (callbacks->closed)
+            return;
+
+        WatchCallbacks *cb = callbacks;
+        auto batch = std::make_shared<std::vector<PrinterEventNative>>(events);
+        tsfn.NonBlockingCall([cb, batch](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            for (auto &e : *batch)
+            {
+                if (cb->closed)
+                    return;
+                cb->callback.Call({ JsPrinterEvent(env, e) });
+            }
+        });
+    }
+
+    void OnError(const std::string &message) override
+    {
+        if (callbacks->closed || callbacks->onError.IsEmpty())
+            return;
+
+        WatchCallbacks *cb = callbacks;
+        tsfn.NonBlockingCall([cb, message](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            if (cb->closed)
+                return;
+            cb->onError.Call({ Napi::Error::New(env, message).Value() });
+        });
+    }
+
+private:
+    Napi::ThreadSafeFunction tsfn;
+    WatchCallbacks *callbacks;
+};
+
+// watch({ printers, events, onError }, callback) -> unsubscribe()
+Napi::Value watch(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction())
+        Napi::TypeError::New(env, "watch({ printers, events }, callback)").ThrowAsJavaScriptException();
+
+    auto service = Service(env);
+    if (!service->Backend().SupportsEvents())
+    {
+        Napi::Error err = Napi::Error::New(env, "Printer events are not supported on this platform");
+        err.Set("code", Napi::String::New(env, "ENOTSUP"));
+        err.ThrowAsJavaScriptException();
+    }
+
+    Napi::Object opt = info[0].As<Napi::Object>();
+    PrinterWatchFilter filter;
+
+    if (opt.Has("printers") && opt.Get("printers").IsArray())
+    {
+        Napi::Array arr = opt.Get("printers").As<Napi::Array>();
+        for (uint32_t i = 0; i < arr.Length(); i++)
+            filter.printers.insert(arr.Get(i).ToString().Utf8Value());
+    }
+
+    if (opt.Has("events") && opt.Get("events").IsArray())
+    {
+        Napi::Array arr = opt.Get("events").As<Napi::Array>();
+        for (uint32_t i = 0; i < arr.Length(); i++)
+        {
+            auto e = arr.Get(i).ToString().Utf8Value();
+            if (!PrinterWatchFilter::IsKnownEvent(e))
+                Napi::TypeError::New(env, "unknown printer event: " + e).ThrowAsJavaScriptException();
+            filter.events.insert(e);
+        }
+    }
+    if (filter.events.empty())
+        filter.events = { "job-state-changed", "printer-state-changed" };
+
+    Napi::Function onError;
+    if (opt.Has("onError") && opt.Get("onError").IsFunction())
+        onError = opt.Get("onError").As<Napi::Function>();
+
+    auto listener = std::make_shared<JsWatchListener>(env, info[1].As<Napi::Function>(), onError);
+    uint64_t id = service->Watcher().Add(filter, listener);
+
+    std::weak_ptr<JsWatchListener> weakListener = listener;
+    std::weak_ptr<PrinterService> weakService = service;
+    return Napi::Function::New(env, [id, weakListener, weakService](const Napi::CallbackInfo &)
+    {
+        if (auto l = weakListener.lock())
+            l->Close();
+        if (auto s = weakService.lock())
+            s->Watcher().Remove(id);
+    });
+}
+
+/* =========================================================
+   Job Watch
+   Job states from the service's JobPoller: one listing of
+   each printer's active jobs per tick, on any platform.
+========================================================= */
+
+class JsJobWatchListener : public JobWatchListener
+{
+public:
+    JsJobWatchListener(Napi::Env env, Napi::Function callback)
+        : callbacks(new WatchCallbacks())
+    {
+        callbacks->callback = Napi::Persistent(callback);
+
+        tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo &) {}),
+            "electronPrinterJobWatch",
+            0,
+            1,
+            callbacks,
+            [](Napi::Env, WatchCallbacks *cb) { delete cb; });
+    }
+
+    ~JsJobWatchListener() override
+    {
+        tsfn.Release();
+    }
+
+    void Close()
+    {
+        callbacks->closed = true;
+    }
+
+    void OnJobUpdate(const JobDetailsNative &job) override
+    {
+        if (callbacks->closed)
+            return;
+
+        WatchCallbacks *cb = callbacks;
+        tsfn.NonBlockingCall([cb, job](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            if (cb->closed)
+                return;
+            cb->callback.Call({ JsJobDetails(env, job, JOB_TIMES) });
+        });
+    }
+
+private:
+    Napi::ThreadSafeFunction tsfn;
+    WatchCallbacks *callbacks;
+};
+
+// watchJob(printerName, jobId, callback) -> unsubscribe()
+Napi::Value watchJob(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 3 || !info[0].IsString() || !info[1].IsNumber() || !info[2].IsFunction())
+        Napi::TypeError::New(env, "watchJob(printerName, jobId, callback)").ThrowAsJavaScriptException();
+
+    auto service = Service(env);
+    auto listener = std::make_shared<JsJobWatchListener>(env, info[2].As<Napi::Function>());
+    uint64_t id = service->Poller().Add(
+        info[0].As<Napi::String>().Utf8Value(),
+        info[1].As<Napi::Number>().Int32Value(),
+        listener);
+
+    std::weak_ptr<JsJobWatchListener> weakListener = listener;
+    std::weak_ptr<PrinterService> weakService = service;
+    return Napi::Function::New(env, [id, weakListener, weakService](const Napi::CallbackInfo &)
+    {
+        if (auto l = weakListener.lock())
+            l->Close();
+        if (auto s = weakService.lock())
+            s->Poller().Remove(id);
+    });
+}
+
+/* =========================================================
+   Wait For Job
+   Resolved from native code, by whichever sees the job reach a
+   requested state first: the JobPoller, or the job-state events
+   of the shared subscription when the backend has one. The
+   poller's first check resolves a job already finished and
+   gives the creation time the event path needs; an event that
+   arrives before it is held until then. A job the printer does
+   not have, or one that finished in another state, rejects.
+========================================================= */
+
+// JS side of one wait. Only touched on the JS thread; deleted by the
+// waiter's TSFN finalizer.
+struct WaitCallbacks
+{
+    explicit WaitCallbacks(Napi::Env env)
+        : deferred(Napi::Promise::Deferred::New(env))
+    {
+    }
+
+    Napi::Promise::Deferred deferred;
+    Napi::Reference<Napi::Value> timer; // setTimeout handle for timeoutMs
+    std::function<void()> detach;       // drops the poller / watcher registrations
+    bool settled = false;
+};
+
+// Marks the wait settled and stops its timer; false if it already was
+static bool BeginSettle(Napi::Env env, WaitCallbacks *cb)
+{
+    if (cb->settled)
+        return false;
+
+    cb->settled = true;
+    if (!cb->timer.IsEmpty())
+    {
+        env.Global().Get("clearTimeout").As<Napi::Function>().Call({ cb->timer.Value() });
+        cb->timer.Reset();
+    }
+    return true;
+}
+
+class JsJobWaiter : public JobWatchListener, public PrinterWatchListener
+{
+public:
+    JsJobWaiter(Napi::Env env, WaitCallbacks *callbacks, std::weak_ptr<PrinterService> service,
+                int jobId, std::set<std::string> states)
+        : callbacks(callbacks), service(std::move(service)), jobId(jobId), states(std::move(states))
+    {
+        tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo &) {}),
+            "electronPrinterWaitForJob",
+            0,
+            1,
+            callbacks,
+            [](Napi::Env env, WaitCallbacks *cb)
+            {
+                // The service shut down under a wait still pending
+                try
+                {
+                    if (BeginSettle(env, cb))
+                        cb->deferred.Reject(Napi::Error::New(env, "Printer service shut down").Value());
+                }
+                catch (const Napi::Error &)
+                {
+                }
+                delete cb;
+            });
+    }
+
+    ~JsJobWaiter() override
+    {
+        tsfn.Release();
+    }
+
+    // On the JS thread, with what waitForJob registered
+    void Registered(uint64_t poll, uint64_t watch)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        pollId = poll;
+        watchId = watch;
+    }
+
+    // On the JS thread once settled (or timed out)
+    void Detach()
+    {
+        uint64_t poll, watch;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            done = true;
+            poll = pollId;
+            watch = watchId;
+            pollId = watchId = 0;
+        }
+        if (auto s = service.lock())
+        {
+            if (poll)
+                s->Poller().Remove(poll);
+            if (watch)
+                s->Watcher().Remove(watch);
+        }
+    }
+
+    void OnJobUpdate(const JobDetailsNative &job) override
+    {
+        if (done)
+            return;
+
+        if (Reached(job.status))
+        {
+            Finish(job);
+            return;
+        }
+
+        bool early;
+        PrinterEventNative e;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            known = job;
+            seen = true;
+            early = pending;
+            e = std::move(event);
+            pending = false;
+        }
+
+        // An event got there first; it is newer than this poll
+        if (early)
+            Finish(FromEvent(job, e));
+        else if (JobPoller::IsFinal(job.status))
+            Fail("Job finished as " + job.status[0], "EJOBFINISHED");
+    }
+
+    void OnJobMissing() override
+    {
+        Fail("Job not found", "ENOENT");
+    }
+
+    void OnEvents(const std::vector<PrinterEventNative> &batch) override
+    {
+        for (auto &e : batch)
+        {
+            if (e.jobId != jobId || !Reached(e.status))
+                continue;
+
+            JobDetailsNative job;
+            {
+                std::lock_guard<std::mutex> lock(mu);
+                if (!seen)
+                {
+                    // Settled by the poller's first check, which has the
+                    // creation time
+                    pending = true;
+                    event = e;
+                    return;
+                }
+                job = known;
+            }
+            Finish(FromEvent(job, e));
+            return;
+        }
+    }
+
+    // The poller keeps checking meanwhile
+    void OnError(const std::string &) override
+    {
+    }
+
+private:
+    bool Reached(const std::vector<std::string> &status) const
+    {
+        for (auto &st : status)
+            if (states.count(st))
+                return true;
+        return false;
+    }
+
+    static JobDetailsNative FromEvent(JobDetailsNative job, const PrinterEventNative &e)
+    {
+        job.status = e.status;
+        if (JobPoller::IsFinal(e.status))
+            job.completedTime = e.time;
+        return job;
+    }
+
+    void Fail(const std::string &message, const std::string &code)
+    {
+        if (done.exchange(true))
+            return;
+
+        WaitCallbacks *cb = callbacks;
+        tsfn.NonBlockingCall([cb, message, code](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            if (!BeginSettle(env, cb))
+                return;
+
+            Napi::Error err = Napi::Error::New(env, message);
+            err.Set("code", Napi::String::New(env, code));
+            cb->deferred.Reject(err.Value());
+            cb->detach();
+        });
+    }
+
+    void Finish(JobDetailsNative job)
+    {
+        if (done.exchange(true))
+            return;
+
+        WaitCallbacks *cb = callbacks;
+        tsfn.NonBlockingCall([cb, job](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            if (!BeginSettle(env, cb))
+                return;
+
+            Napi::Object result = JsJobDetails(env, job, JOB_TIMES);
+            if (job.creationTime)
+            {
+                std::time_t end = job.completedTime ? job.completedTime : std::time(nullptr);
+                result.Set("totalTimeMs", (double)(end - job.creationTime) * 1000.0);
+            }
+            cb->deferred.Resolve(result);
+            cb->detach();
+        });
+    }
+
+    Napi::ThreadSafeFunction tsfn;
+    WaitCallbacks *callbacks;
+    std::weak_ptr<PrinterService> service;
+    const int jobId;
+    const std::set<std::string> states;
+
+    std::atomic<bool> done{false};
+    std::mutex mu;
+    JobDetailsNative known; // last poll, for the event path
+    bool seen = false;
+    PrinterEventNative event; // reached before the first poll
+    bool pending = false;
+    uint64_t pollId = 0;
+    uint64_t watchId = 0;
+};
+
+// waitForJob(printerName, jobId, { states, timeoutMs })
+//   -> Promise<job & { totalTimeMs }>
+Napi::Value waitForJob(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+    if (info.Length() < 2 || !info[0].IsString() || !info[1].IsNumber())
+        Napi::TypeError::New(env, "waitForJob(printerName, jobId, { states, timeoutMs })").ThrowAsJavaScriptException();
+
+    std::string printerName = info[0].As<Napi::String>().Utf8Value();
+    int jobId = info[1].As<Napi::Number>().Int32Value();
+
+    std::set<std::string> states;
+    uint32_t timeoutMs = 0;
+    if (info.Length() > 2 && info[2].IsObject())
+    {
+        Napi::Object opt = info[2].As<Napi::Object>();
+        if (opt.Has("states") && opt.Get("states").IsArray())
+        {
+            Napi::Array arr = opt.Get("states").As<Napi::Array>();
+            for (uint32_t i = 0; i < arr.Length(); i++)
+                states.insert(arr.Get(i).ToString().Utf8Value());
+        }
+        if (opt.Has("timeoutMs") && opt.Get("timeoutMs").IsNumber())
+            timeoutMs = opt.Get("timeoutMs").As<Napi::Number>().Uint32Value();
+    }
+    if (states.empty())
+        states = { "PRINTED", "CANCELLED", "ABORTED" };
+
+    auto service = Service(env);
+
+    WaitCallbacks *cb = new WaitCallbacks(env);
+    Napi::Promise promise = cb->deferred.Promise();
+    auto waiter = std::make_shared<JsJobWaiter>(env, cb, service, jobId, states);
+
+    std::weak_ptr<JsJobWaiter> weakWaiter = waiter;
+    cb->detach = [weakWaiter]()
+    {
+        if (auto w = weakWaiter.lock())
+            w->Detach();
+    };
+
+    uint64_t watchId = 0;
+    if (service->Backend().SupportsEvents())
+    {
+        PrinterWatchFilter filter;
+        if (!printerName.empty())
+            filter.printers.insert(printerName);
+        filter.events = { "job-state-changed" };
+        watchId = service->Watcher().Add(filter, waiter);
+    }
+    waiter->Registered(service->Poller().Add(printerName, jobId, waiter), watchId);
+
+    if (timeoutMs > 0)
+    {
+        Napi::Function onTimeout = Napi::Function::New(env, [cb](const Napi::CallbackInfo &info)
+        {
+            auto env = info.Env();
+            cb->timer.Reset(); // fired, nothing to clear
+            if (!BeginSettle(env, cb))
+                return;
+
+            Napi::Error err = Napi::Error::New(env, "Timed out waiting for the job");
+            err.Set("code", Napi::String::New(env, "ETIMEDOUT"));
+            cb->deferred.Reject(err.Value());
+            cb->detach();
+        });
+        Napi::Value timer = env.Global().Get("setTimeout").As<Napi::Function>().Call(
+            { onTimeout, Napi::Number::New(env, timeoutMs) });
+        cb->timer = Napi::Persistent(timer);
+    }
+
+    return promise;
+}
+
+/* =========================================================
+   Print Jobs
+   Submissions run on the service's PrintExecutor (one FIFO
+   queue per printer, not the libuv threadpool). Each job
+   reports back through its own ThreadSafeFunction.
+========================================================= */
+
+// JS side of one job. Only touched on the JS thread; deleted by the
+// job's TSFN finalizer after the executor side has released it.
+struct PrintCallbacks
+{
+    Napi::FunctionReference success;
+    Napi::FunctionReference error;
+    Napi::FunctionReference progress;
+    std::vector<Napi::ObjectReference> retained;
+
+    // Latest progress, written by the worker and read by the queued call
+    std::atomic<uint64_t> progressSent{0};
+    std::atomic<uint64_t> progressTotal{0};
+    std::atomic<bool> progressQueued{false};
+
+    // opt.signal and the job's 'abort' listener on it, until it settles
+    Napi::ObjectReference signal;
+    Napi::FunctionReference abortListener;
+};
+
+// A settled job stops listening, so a long-lived AbortSignal reused
+// across jobs does not collect listeners (and pin every job).
+static void DetachAbortSignal(Napi::Env env, PrintCallbacks *cb)
+{
+    if (cb->signal.IsEmpty())
+        return;
+
+    Napi::Object signal = cb->signal.Value();
+    Napi::Value remove = signal.Get("removeEventListener");
+    if (remove.IsFunction())
+        remove.As<Napi::Function>().Call(
+            signal, { Napi::String::New(env, "abort"), cb->abortListener.Value() });
+
+    cb->signal.Reset();
+    cb->abortListener.Reset();
+}
+
+// Minimum spacing of onProgress calls for one job
+static const std::chrono::milliseconds kProgressInterval(50);
+
+// What an AbortSignal-cancelled job rejects with, as Node's own APIs do
+static Napi::Error AbortError(Napi::Env env)
+{
+    Napi::Error err = Napi::Error::New(env, "The operation was aborted");
+    err.Set("name", Napi::String::New(env, "AbortError"));
+    err.Set("code", Napi::String::New(env, "ABORT_ERR"));
+    return err;
+}
+
+class JsPrintTask : public PrintTask
+{
+public:
+    JsPrintTask(Napi::Env env, Napi::Function successCb, Napi::Function errorCb)
+        : callbacks(new PrintCallbacks())
+    {
+        callbacks->success = Napi::Persistent(successCb);
+        callbacks->error = Napi::Persistent(errorCb);
+
+        tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo &) {}),
+            "electronPrinterJob",
+            0,
+            1,
+            callbacks,
+            [](Napi::Env env, PrintCallbacks *cb)
+            {
+                try
+                {
+                    DetachAbortSignal(env, cb);
+                }
+                catch (const Napi::Error &)
+                {
+                }
+                delete cb;
+            });
+    }
+
+    ~JsPrintTask() override
+    {
+        tsfn.Release();
+    }
+
+    // Keeps a JS value (a payload Buffer) alive until the job settles,
+    // so Run can read it without a copy.
+    void Retain(Napi::Object value)
+    {
+        callbacks->retained.push_back(Napi::Persistent(value));
+    }
+
+    // Optional onProgress(bytesSent, totalBytes)
+    void SetProgressCallback(Napi::Function cb)
+    {
+        callbacks->progress = Napi::Persistent(cb);
+        wantsProgress = true;
+    }
+
+    void Expire() override
+    {
+        Reject("Print job deadline passed before it started", "ETIMEDOUT");
+    }
+
+    // Aborting drops the job if it is still queued and stops its upload
+    // between chunks otherwise.
+    void SetAbortSignal(Napi::Env env, Napi::Object signal, std::weak_ptr<PrinterService> service)
+    {
+        abortFlag = std::make_shared<std::atomic<bool>>(signal.Get("aborted").ToBoolean().Value());
+
+        auto flag = abortFlag;
+        Napi::Function listener = Napi::Function::New(env, [flag, service](const Napi::CallbackInfo &)
+        {
+            *flag = true;
+            if (auto s = service.lock())
+                s->Executor().PurgeCancelled();
+        });
+
+        Napi::Object listenerOpts = Napi::Object::New(env);
+        listenerOpts.Set("once", true);
+        signal.Get("addEventListener").As<Napi::Function>().Call(
+            signal, { Napi::String::New(env, "abort"), listener, listenerOpts });
+
+        callbacks->signal = Napi::Persistent(signal);
+        callbacks->abortListener = Napi::Persistent(listener);
+    }
+
+    bool Cancelled() const override
+    {
+        return abortFlag && abortFlag->load();
+    }
+
+    void Cancel() override
+    {
+        PrintCallbacks *cb = callbacks;
+        tsfn.BlockingCall([cb](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            DetachAbortSignal(env, cb);
+            cb->error.Call({ AbortError(env).Value() });
+        });
+    }
+
+protected:
+    using ResultFn = std::function<Napi::Value(Napi::Env)>;
+
+    void Resolve(ResultFn result)
+    {
+        PrintCallbacks *cb = callbacks;
+        tsfn.BlockingCall([cb, result](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            DetachAbortSignal(env, cb);
+            cb->success.Call({ result(env) });
+        });
+    }
+
+    void Reject(const std::string &message, const std::string &code = std::string())
+    {
+        PrintCallbacks *cb = callbacks;
+        tsfn.BlockingCall([cb, message, code](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            DetachAbortSignal(env, cb);
+            Napi::Error err = Napi::Error::New(env, message);
+            if (!code.empty())
+                err.Set("code", Napi::String::New(env, code));
+            cb->error.Call({ err.Value() });
+        });
+    }
+
+    void RejectTimeout(TimeoutKind kind)
+    {
+        PrintCallbacks *cb = callbacks;
+        tsfn.BlockingCall([cb, kind](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            DetachAbortSignal(env, cb);
+            Napi::Error err = Napi::Error::New(env, TimeoutMessage("Print", kind));
+            SetTimeoutFields(env, err, kind);
+            cb->error.Call({ err.Value() });
+        });
+    }
+
+    // Settles a job the backend gave up on; a failure that was still
+    // transient after the last retry carries code EAGAIN.
+    void RejectFailed()
+    {
+        SubmitFailure failure = LastSubmitFailure();
+
+        if (LastTimeout() != TimeoutKind::None)
+            RejectTimeout(LastTimeout());
+        else if (failure == SubmitFailure::Transient || failure == SubmitFailure::TransientJobMayExist)
+            Reject("Print failed (printer unavailable)", "EAGAIN");
+        else
+            Reject("Print failed");
+    }
+
+    // Throttled: calls are at least kProgressInterval apart and at most
+    // one is queued at a time, reporting the latest values when it runs.
+    void Progress(uint64_t sent, uint64_t total)
+    {
+        callbacks->progressSent = sent;
+        callbacks->progressTotal = total;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastProgressAt >= kProgressInterval)
+            PostProgress(now);
+    }
+
+    // Delivers progress held back by the throttle; before settling the job.
+    void FlushProgress()
+    {
+        if (wantsProgress && callbacks->progressSent != postedSent)
+            PostProgress(std::chrono::steady_clock::now());
+    }
+
+    bool wantsProgress = false;
+    std::shared_ptr<std::atomic<bool>> abortFlag;
+
+private:
+    void PostProgress(std::chrono::steady_clock::time_point now)
+    {
+        lastProgressAt = now;
+        postedSent = callbacks->progressSent;
+
+        PrintCallbacks *cb = callbacks;
+        if (cb->progressQueued.exchange(true))
+            return;
+
+        tsfn.NonBlockingCall([cb](Napi::Env env, Napi::Function)
+        {
+            Napi::HandleScope scope(env);
+            cb->progressQueued = false;
+            cb->progress.Call({
+                Napi::Number::New(env, (double)cb->progressSent.load()),
+                Napi::Number::New(env, (double)cb->progressTotal.load())
+            });
+        });
+    }
+
+    Napi::ThreadSafeFunction tsfn;
+    PrintCallbacks *callbacks;
+    std::chrono::steady_clock::time_point lastProgressAt;
+    uint64_t postedSent = 0;
+};
+
+// Single-document job; success receives the job id as a string.
+class PrintJob : public JsPrintTask
+{
+public:
+    using WorkFn = std::function<int(const PrintControl &)>;
+
+    PrintJob(Napi::Env env, Napi::Function successCb, Napi::Function errorCb, WorkFn workFn)
+        : JsPrintTask(env, successCb, errorCb),
+          work(std::move(workFn))
+    {}
+
+    // IPP job-priority sent with the job; 0 leaves the server default
+    void SetJobPriority(int priority)
+    {
+        jobPriority = priority;
+    }
+
+    void Run() override
+    {
+        if (Cancelled())
+        {
+            Cancel();
+            return;
+        }
+
+        PrintControl control;
+        control.priority = jobPriority;
+        control.cancelled = abortFlag.get();
+        control.timeouts = timeouts;
+        if (wantsProgress)
+        {
+            control.onProgress = [this](uint64_t sent, uint64_t total)
+            {
+                Progress(sent, total);
+            };
+        }
+
+        int jobId = 0;
+        LastTimeout() = TimeoutKind::None;
+        LastSubmitFailure() = SubmitFailure::None;
+        try
+        {
+            jobId = work(control);
+        }
+        catch (...)
+        {
+            Reject("Print failed (exception)");
+            return;
+        }
+
+        FlushProgress();
+
+        if (jobId <= 0 && Cancelled())
+        {
+            Cancel();
+            return;
+        }
+
+        if (jobId <= 0)
+        {
+            RejectFailed();
+            return;
+        }
+
+        Resolve([jobId](Napi::Env env) -> Napi::Value
+        {
+            return Napi::String::New(env, std::to_string(jobId));
+        });
+    }
+
+    // Overrides the backend's timeouts for this job
+    void SetTimeouts(const CallTimeouts &t)
+    {
+        timeouts = t;
+    }
+
+private:
+    WorkFn work;
+    int jobPriority = 0;
+    CallTimeouts timeouts;
+};
+
+// A small RAW document riding in a coalesced job; settles with the job
+// id of the job that carried it.
+class CoalescedPrint : public JsPrintTask, public CoalescedDocument
+{
+public:
+    CoalescedPrint(Napi::Env env, Napi::Function successCb, Napi::Function errorCb, ByteSpan data,
+                   std::shared_ptr<std::string> text)
+        : JsPrintTask(env, successCb, errorCb),
+          data(data),
+          text(std::move(text))
+    {}
+
+    // Never queued on its own; the coalescer's batch task prints it.
+    void Run() override {}
+
+    ByteSpan Data() const override
+    {
+        return data;
+    }
+
+    void Complete(int jobId, const std::string &error, TimeoutKind timeout) override
+    {
+        if (timeout != TimeoutKind::None)
+        {
+            RejectTimeout(timeout);
+            return;
+        }
+
+        if (!error.empty())
+        {
+            Reject(error);
+            return;
+        }
+
+        Resolve([jobId](Napi::Env env) -> Napi::Value
+        {
+            return Napi::String::New(env, std::to_string(jobId));
+        });
+    }
+
+private:
+    ByteSpan data;
+    std::shared_ptr<std::string> text;
+};
+
+// opt.queueFull: 'reject' (default) fails the job with EQUEUEFULL when
+// a queue limit is hit, 'wait' parks it until earlier jobs finish.
+static bool ParseWaitIfFull(Napi::Env env, Napi::Object opt)
+{
+    if (!opt.Has("queueFull") || !opt.Get("queueFull").IsString())
+        return false;
+
+    std::string policy = opt.Get("queueFull").As<Napi::String>().Utf8Value();
+    if (policy == "wait")
+        return true;
+    if (policy != "reject")
+        Napi::TypeError::New(env, "queueFull must be 'reject' or 'wait'").ThrowAsJavaScriptException();
+    return false;
+}
+
+// opt.priority: 1 (bulk) .. 100 (urgent), default 50.
+// opt.deadline: ms from now by which the job must have started;
+// a job still queued then fails with ETIMEDOUT.
+static PrintTaskOptions ParseTaskOptions(Napi::Env env, Napi::Object opt, size_t bytes)
+{
+    PrintTaskOptions options;
+    options.bytes = bytes;
+    options.waitIfFull = ParseWaitIfFull(env, opt);
+
+    if (opt.Has("priority") && !opt.Get("priority").IsUndefined())
+    {
+        if (!opt.Get("priority").IsNumber())
+            Napi::TypeError::New(env, "priority must be a number").ThrowAsJavaScriptException();
+
+        int priority = opt.Get("priority").As<Napi::Number>().Int32Value();
+        if (priority < 1 || priority > 100)
+            Napi::RangeError::New(env, "priority must be between 1 and 100").ThrowAsJavaScriptException();
+        options.priority = priority;
+    }
+
+    if (opt.Has("deadline") && !opt.Get("deadline").IsUndefined())
+    {
+        if (!opt.Get("deadline").IsNumber())
+            Napi::TypeError::New(env, "deadline must be a number of milliseconds").ThrowAsJavaScriptException();
+
+        int64_t ms = std::max<int64_t>(0, opt.Get("deadline").As<Napi::Number>().Int64Value());
+        options.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    }
+
+    return options;
+}
+
+// opt.retries overrides the policy's retry count for this job.
+// opt.idempotencyKey names the job so a resubmission finds it instead of
+// printing again; returned empty when not given.
+static std::string ParseRetryOptions(Napi::Env env, Napi::Object opt, RetryPolicy &policy)
+{
+    if (opt.Has("retries") && !opt.Get("retries").IsUndefined())
+    {
+        if (!opt.Get("retries").IsNumber())
+            Napi::TypeError::New(env, "retries must be a number").ThrowAsJavaScriptException();
+        policy.retries = (unsigned)std::max<int64_t>(0, opt.Get("retries").As<Napi::Number>().Int64Value());
+    }
+
+    if (!opt.Has("idempotencyKey") || opt.Get("idempotencyKey").IsUndefined())
+        return std::string();
+
+    if (!opt.Get("idempotencyKey").IsString())
+        Napi::TypeError::New(env, "idempotencyKey must be a string").ThrowAsJavaScriptException();
+    return opt.Get("idempotencyKey").As<Napi::String>().Utf8Value();
+}
+
+// opt.signal: an AbortSignal for the job. False if it has already fired,
+// after reporting AbortError through errorCb.
+static bool AttachAbortSignal(Napi::Env env, Napi::Object opt, JsPrintTask &job,
+                              const std::shared_ptr<PrinterService> &service, Napi::Function errorCb)
+{
+    if (!opt.Has("signal") || opt.Get("signal").IsUndefined())
+        return true;
+
+    Napi::Value signal = opt.Get("signal");
+    if (!signal.IsObject() || !signal.As<Napi::Object>().Get("addEventListener").IsFunction())
+        Napi::TypeError::New(env, "signal must be an AbortSignal").ThrowAsJavaScriptException();
+
+    job.SetAbortSignal(env, signal.As<Napi::Object>(), service);
+    if (job.Cancelled())
+    {
+        errorCb.Call({ AbortError(env).Value() });
+        return false;
+    }
+    return true;
+}
+
+// An explicit priority is also sent to the server as IPP job-priority.
+static int IppPriority(Napi::Object opt, const PrintTaskOptions &options)
+{
+    return opt.Has("priority") && opt.Get("priority").IsNumber() ? options.priority : 0;
+}
+
+static void ReportAdmission(Napi::Env env, PrintExecutor::Admission admission, Napi::Function errorCb)
+{
+    switch (admission)
+    {
+    case PrintExecutor::Admission::Queued:
+    case PrintExecutor::Admission::Waiting:
+        return;
+
+    case PrintExecutor::Admission::Full:
+    {
+        Napi::Error err = Napi::Error::New(env, "Print queue is full");
+        err.Set("code", Napi::String::New(env, "EQUEUEFULL"));
+        errorCb.Call({ err.Value() });
+        return;
+    }
+
+    case PrintExecutor::Admission::Stopped:
+        errorCb.Call({ Napi::Error::New(env, "Printer service is shut down").Value() });
+        return;
+    }
+}
+
+// Queues the job on its printer's queue, keyed on the cached default for
+// '' so it shares one queue and its order with the default printer's own
+// name, without a backend round trip on the JS thread.
+static void SubmitPrintJob(Napi::Env env,
+                           PrinterService &service,
+                           const std::string &printerName,
+                           std::unique_ptr<JsPrintTask> job,
+                           const PrintTaskOptions &options,
+                           Napi::Function errorCb)
+{
+    std::string queueKey = service.QueueKey(printerName);
+    ReportAdmission(env, service.Executor().Submit(queueKey, std::move(job), options), errorCb);
+}
+
+// Small RAW jobs without per-job options, progress, signal, timeout,
+// priority, deadline or retry settings can share one job with their
+// neighbours when coalescing is on (opt.coalesce: false opts out).
+static bool CanCoalesce(PrinterService &service, Napi::Object opt, const std::string &type,
+                        const StringMap &driverOpts, size_t bytes)
+{
+    if (opt.Has("coalesce") && opt.Get("coalesce").IsBoolean() && !opt.Get("coalesce").As<Napi::Boolean>().Value())
+        return false;
+
+    std::string t = type;
+    std::transform(t.begin(), t.end(), t.begin(), ::toupper);
+
+    return t == "RAW" && driverOpts.empty() && !opt.Has("onProgress") && !opt.Has("signal") &&
+           !opt.Has("timeout") && !opt.Has("idempotencyKey") && !opt.Has("retries") &&
+           !(opt.Has("priority") && opt.Get("priority").IsNumber()) &&
+           !(opt.Has("deadline") && opt.Get("deadline").IsNumber()) &&
+           service.Coalescer().Accepts(bytes);
+}
+
+static Napi::Function SafeCb(Napi::Env env, Napi::Object opt, const char *key)
+{
+    if (opt.Has(key) && opt.Get(key).IsFunction())
+        return opt.Get(key).As<Napi::Function>();
+
+    return Napi::Function::New(env, [](const Napi::CallbackInfo &) {});
+}
+
+/* =========================================================
+   printDirect
+========================================================= */
+
+Napi::Value printDirect(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "options object required").ThrowAsJavaScriptException();
+
+    Napi::Object opt = info[0].As<Napi::Object>();
+
+    if (!opt.Has("data"))
+        Napi::TypeError::New(env, "options.data required").ThrowAsJavaScriptException();
+
+    std::string printerName;
+    if (opt.Has("printer") && opt.Get("printer").IsString())
+        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+
+    std::string type = "RAW";
+    if (opt.Has("type") && opt.Get("type").IsString())
+        type = opt.Get("type").As<Napi::String>().Utf8Value();
+
+    StringMap driverOpts = ParseStringMap(opt, "options");
+
+    // Buffers are read in place on the worker thread (the worker pins the
+    // Buffer below); strings need one UTF-8 conversion, owned by the job.
+    ByteSpan data;
+    std::shared_ptr<std::string> text;
+    auto d = opt.Get("data");
+
+    if (d.IsBuffer())
+    {
+        auto b = d.As<Napi::Buffer<uint8_t>>();
+        data.data = b.Data();
+        data.size = b.Length();
+    }
+    else
+    {
+        text = std::make_shared<std::string>(d.ToString().Utf8Value());
+        data.data = (const uint8_t *)text->data();
+        data.size = text->size();
+    }
+
+    auto successCb = SafeCb(env, opt, "success");
+    auto errorCb = SafeCb(env, opt, "error");
+    PrinterService *service = Service(env).get();
+
+    if (CanCoalesce(*service, opt, type, driverOpts, data.size))
+    {
+        std::unique_ptr<CoalescedPrint> doc(new CoalescedPrint(env, successCb, errorCb, data, text));
+        if (d.IsBuffer())
+            doc->Retain(d.As<Napi::Object>());
+
+        bool waitIfFull = ParseWaitIfFull(env, opt);
+        ReportAdmission(env, service->Coalescer().Add(service->QueueKey(printerName), std::move(doc), waitIfFull), errorCb);
+        return env.Undefined();
+    }
+
+    RetryPolicy retry = service->GetRetryPolicy();
+    std::string idempotencyKey = ParseRetryOptions(env, opt, retry);
+
+    std::unique_ptr<PrintJob> job(new PrintJob(
+        env,
+        successCb,
+        errorCb,
+        [service, printerName, data, text, type, driverOpts, retry, idempotencyKey](const PrintControl &control) -> int
+        {
+            std::string usePrinter = service->ResolvePrinter(printerName);
+
+            return SubmitWithRetry(service->Backend(), usePrinter, retry, idempotencyKey, control,
+                                   [&](const PrintControl &c)
+                                   {
+                                       return service->Backend().PrintDirect(usePrinter, data, type, driverOpts, c);
+                                   });
+        }));
+
+    if (d.IsBuffer())
+        job->Retain(d.As<Napi::Object>());
+
+    if (opt.Has("onProgress") && opt.Get("onProgress").IsFunction())
+        job->SetProgressCallback(opt.Get("onProgress").As<Napi::Function>());
+
+    if (!AttachAbortSignal(env, opt, *job, Service(env), errorCb))
+        return env.Undefined();
+
+    PrintTaskOptions taskOpts = ParseTaskOptions(env, opt, data.size);
+    job->SetJobPriority(IppPriority(opt, taskOpts));
+
+    // opt.timeout: { connectMs, readMs, totalMs } for this job
+    if (opt.Has("timeout") && opt.Get("timeout").IsObject())
+        job->SetTimeouts(ParseCallTimeouts(opt.Get("timeout").As<Napi::Object>(), CallTimeouts()));
+
+    SubmitPrintJob(env, *service, printerName, std::move(job), taskOpts, errorCb);
+    return env.Undefined();
+}
+
+/* =========================================================
+   printFile
+========================================================= */
+
+Napi::Value printFile(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "options object required").ThrowAsJavaScriptException();
+
+    Napi::Object opt = info[0].As<Napi::Object>();
+
+    if (!opt.Has("filename") || !opt.Get("filename").IsString())
+        Napi::TypeError::New(env, "options.filename required").ThrowAsJavaScriptException();
+
+    std::string filename = opt.Get("filename").As<Napi::String>().Utf8Value();
+
+    std::string printerName;
+    if (opt.Has("printer") && opt.Get("printer").IsString())
+        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+
+    auto successCb = SafeCb(env, opt, "success");
+    auto errorCb = SafeCb(env, opt, "error");
+    PrinterService *service = Service(env).get();
+
+    RetryPolicy retry = service->GetRetryPolicy();
+    std::string idempotencyKey = ParseRetryOptions(env, opt, retry);
+
+    std::unique_ptr<PrintJob> job(new PrintJob(
+        env,
+        successCb,
+        errorCb,
+        [service, printerName, filename, retry, idempotencyKey](const PrintControl &control) -> int
+        {
+            std::string usePrinter = service->ResolvePrinter(printerName);
+
+            return SubmitWithRetry(service->Backend(), usePrinter, retry, idempotencyKey, control,
+                                   [&](const PrintControl &c)
+                                   {
+                                       return service->Backend().PrintFile(usePrinter, filename, c);
+                                   });
+        }));
+
+    if (opt.Has("onProgress") && opt.Get("onProgress").IsFunction())
+        job->SetProgressCallback(opt.Get("onProgress").As<Napi::Function>());
+
+    // The file is streamed from disk: no payload held in memory.
+    if (!AttachAbortSignal(env, opt, *job, Service(env), errorCb))
+        return env.Undefined();
+
+    PrintTaskOptions taskOpts = ParseTaskOptions(env, opt, 0);
+    job->SetJobPriority(IppPriority(opt, taskOpts));
+
+    // opt.timeout: { connectMs, readMs, totalMs } for this job
+    if (opt.Has("timeout") && opt.Get("timeout").IsObject())
+        job->SetTimeouts(ParseCallTimeouts(opt.Get("timeout").As<Napi::Object>(), CallTimeouts()));
+
+    SubmitPrintJob(env, *service, printerName, std::move(job), taskOpts, errorCb);
+    return env.Undefined();
+}
+
+/* =========================================================
+   printBatch
+========================================================= */
+
+class BatchJob : public JsPrintTask
+{
+public:
+    BatchJob(
+        Napi::Env env,
+        Napi::Function successCb,
+        Napi::Function errorCb,
+        PrinterService *service,
+        std::string printerName,
+        std::vector<BatchDocumentNative> documents,
+        StringMap options)
+        : JsPrintTask(env, successCb, errorCb),
+          service(service),
+          printerName(std::move(printerName)),
+          documents(std::move(documents)),
+          options(std::move(options))
+    {}
+
+    // Owns converted strings for the job's lifetime
+    void Own(std::shared_ptr<std::string> text)
+    {
+        texts.push_back(std::move(text));
+    }
+
+    void Run() override
+    {
+        BatchResultNative result;
+        LastTimeout() = TimeoutKind::None;
+        LastSubmitFailure() = SubmitFailure::None;
+        try
+        {
+            std::string usePrinter = service->ResolvePrinter(printerName);
+            result = service->Backend().PrintBatch(usePrinter, documents, options);
+        }
+        catch (...)
+        {
+            Reject("Print failed (exception)");
+            return;
+        }
+
+        if (result.jobId <= 0)
+        {
+            RejectFailed();
+            return;
+        }
+
+        Resolve([result](Napi::Env env) -> Napi::Value
+        {
+            Napi::Object o = Napi::Object::New(env);
+            o.Set("jobId", Napi::String::New(env, std::to_string(result.jobId)));
+
+            Napi::Array docs = Napi::Array::New(env, result.documentErrors.size());
+            for (size_t i = 0; i < result.documentErrors.size(); i++)
+            {
+                Napi::Object d = Napi::Object::New(env);
+                d.Set("index", (double)i);
+                d.Set("ok", result.documentErrors[i].empty());
+                if (!result.documentErrors[i].empty())
+                    d.Set("error", result.documentErrors[i]);
+                docs.Set((uint32_t)i, d);
+            }
+            o.Set("documents", docs);
+            return o;
+        });
+    }
+
+private:
+    std::vector<std::shared_ptr<std::string>> texts;
+    PrinterService *service;
+    std::string printerName;
+    std::vector<BatchDocumentNative> documents;
+    StringMap options;
+};
+
+Napi::Value printBatch(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+
+    if (info.Length() < 1 || !info[0].IsObject())
+        Napi::TypeError::New(env, "options object required").ThrowAsJavaScriptException();
+
+    Napi::Object opt = info[0].As<Napi::Object>();
+
+    if (!opt.Has("documents") || !opt.Get("documents").IsArray())
+        Napi::TypeError::New(env, "options.documents array required").ThrowAsJavaScriptException();
+
+    std::string printerName;
+    if (opt.Has("printer") && opt.Get("printer").IsString())
+        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+
+    Napi::Array docs = opt.Get("documents").As<Napi::Array>();
+    if (docs.Length() == 0)
+        Napi::TypeError::New(env, "options.documents must not be empty").ThrowAsJavaScriptException();
+
+    std::vector<BatchDocumentNative> documents(docs.Length());
+    std::vector<Napi::Object> pinned;
+    std::vector<std::shared_ptr<std::string>> texts;
+
+    for (uint32_t i = 0; i < docs.Length(); i++)
+    {
+        if (!docs.Get(i).IsObject())
+            Napi::TypeError::New(env, "documents[" + std::to_string(i) + "] must be an object").ThrowAsJavaScriptException();
+
+        Napi::Object doc = docs.Get(i).As<Napi::Object>();
+        if (!doc.Has("data"))
+            Napi::TypeError::New(env, "documents[" + std::to_string(i) + "].data required").ThrowAsJavaScriptException();
+
+        if (doc.Has("type") && doc.Get("type").IsString())
+            documents[i].type = doc.Get("type").As<Napi::String>().Utf8Value();
+        if (doc.Has("name") && doc.Get("name").IsString())
+            documents[i].name = doc.Get("name").As<Napi::String>().Utf8Value();
+
+        auto d = doc.Get("data");
+        if (d.IsBuffer())
+        {
+            auto b = d.As<Napi::Buffer<uint8_t>>();
+            documents[i].data.data = b.Data();
+            documents[i].data.size = b.Length();
+            pinned.push_back(b);
+        }
+        else
+        {
+            auto text = std::make_shared<std::string>(d.ToString().Utf8Value());
+            documents[i].data.data = (const uint8_t *)text->data();
+            documents[i].data.size = text->size();
+            texts.push_back(text);
+        }
+    }
+
+    size_t totalBytes = 0;
+    for (auto &doc : documents)
+        totalBytes += doc.data.size;
+
+    auto errorCb = SafeCb(env, opt, "error");
+    PrinterService *service = Service(env).get();
+
+    std::unique_ptr<BatchJob> job(new BatchJob(
+        env,
+        SafeCb(env, opt, "success"),
+        errorCb,
+        service,
+        printerName,
+        std::move(documents),
+        ParseStringMap(opt, "options")));
+
+    for (auto &b : pinned)
+        job->Retain(b);
+    for (auto &t : texts)
+        job->Own(t);
+
+    PrintTaskOptions taskOpts;
+    taskOpts.bytes = totalBytes;
+    taskOpts.waitIfFull = ParseWaitIfFull(env, opt);
+
+    SubmitPrintJob(env, *service, printerName, std::move(job), taskOpts, errorCb);
+    return env.Undefined();
+}
+
+/* =========================================================
+   Print Streams
+   One thread per stream writes chunks in order; each write
+   callback fires only once the backend has taken the chunk.
+   Streams are registered with the service, which aborts them
+   on shutdown; a handle collected without end() aborts too.
+========================================================= */
+
+class PrintStreamSession
+{
+public:
+    struct Op
+    {
+        enum Kind { WRITE, FINISH, ABORT };
+
+        Kind kind = WRITE;
+        ByteSpan data;
+        Napi::ObjectReference chunkRef; // pins the chunk Buffer
+        Napi::FunctionReference callback;
+        std::string error;
+        int jobId = 0;
+    };
+
+    static std::shared_ptr<PrintStreamSession> Start(Napi::Env env,
+                                                     std::string printerName,
+                                                     std::string type,
+                                                     StringMap options)
+    {
+        auto session = std::shared_ptr<PrintStreamSession>(new PrintStreamSession());
+        session->service = Service(env);
+        session->printerName = std::move(printerName);
+        session->type = std::move(type);
+        session->options = std::move(options);
+        session->tsfn = Napi::ThreadSafeFunction::New(
+            env,
+            Napi::Function::New(env, [](const Napi::CallbackInfo &) {}),
+            "electronPrinterStream",
+            0,
+            1);
+
+        std::weak_ptr<PrintStreamSession> weak = session;
+        session->streamId = session->service->AddStream([weak]()
+        {
+            if (auto s = weak.lock())
+                s->Abort();
+        });
+
+        std::thread([session]() { session->Run(); }).detach();
+        return session;
+    }
+
+    // Ops carrying JS references are pushed on the JS thread only. Ops
+    // pushed after the stream closed are dropped here.
+    bool Push(Op *op)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (!closed)
+            {
+                ops.push_back(op);
+                cv.notify_one();
+                return true;
+            }
+        }
+
+        delete op;
+        return false;
+    }
+
+    // Any thread
+    void Abort()
+    {
+        auto op = new Op();
+        op->kind = Op::ABORT;
+        Push(op);
+    }
+
+private:
+    PrintStreamSession() = default;
+
+    Op *Pop()
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [this]() { return !ops.empty(); });
+        Op *op = ops.front();
+        ops.pop_front();
+        return op;
+    }
+
+    void Complete(Op *op)
+    {
+        tsfn.BlockingCall(op, [](Napi::Env env, Napi::Function, Op *done)
+        {
+            Napi::HandleScope scope(env);
+            if (!done->callback.IsEmpty())
+            {
+                Napi::Value err = done->error.empty()
+                    ? env.Null()
+                    : Napi::Error::New(env, done->error).Value();
+
+                done->callback.Call({ err, Napi::String::New(env, std::to_string(done->jobId)) });
+            }
+            delete done;
+        });
+    }
+
+    void Run()
+    {
+        std::string usePrinter = service->ResolvePrinter(printerName);
+
+        std::string failure;
+        std::unique_ptr<PrintStreamNative> stream;
+        if (!streamId)
+            failure = "Printer service shut down";
+        else if (!(stream = service->Backend().OpenPrintStream(usePrinter, type, options)))
+            failure = "Could not open print job";
+
+        bool finished = false;
+        while (!finished)
+        {
+            Op *op = Pop();
+
+            switch (op->kind)
+            {
+            case Op::WRITE:
+                if (failure.empty() && !stream->Write(op->data))
+                    failure = "Print stream write failed";
+                op->error = failure;
+                break;
+
+            case Op::FINISH:
+                if (failure.empty())
+                {
+                    op->jobId = stream->Finish();
+                    if (op->jobId <= 0)
+                        failure = "Print failed";
+                }
+                op->error = failure;
+                finished = true;
+                break;
+
+            case Op::ABORT:
+                if (stream)
+                    stream->Abort();
+                finished = true;
+                break;
+            }
+
+            Complete(op);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            closed = true;
+        }
+
+        // Anything queued behind FINISH/ABORT still gets its callback.
+        for (Op *op : ops)
+        {
+            op->error = "Print stream is closed";
+            Complete(op);
+        }
+        ops.clear();
+
+        stream.reset();
+        if (streamId)
+            service->RemoveStream(streamId);
+        tsfn.Release();
+    }
+
+    std::shared_ptr<PrinterService> service;
+    std::string printerName;
+    std::string type;
+    StringMap options;
+
+    Napi::ThreadSafeFunction tsfn;
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Op *> ops;
+    bool closed = false;
+    uint64_t streamId = 0; // 0: the service was shutting down
+};
+
+/* =========================================================
+   openPrintStream
+   Returns { write(chunk, cb), end(cb), abort() }; the JS
+   Writable in createPrintStream drives it.
+========================================================= */
+
+Napi::Value openPrintStream(const Napi::CallbackInfo &info)
+{
+    auto env = info.Env();
+
+    Napi::Object opt = Napi::Object::New(env);
+    if (info.Length() >= 1 && info[0].IsObject())
+        opt = info[0].As<Napi::Object>();
+
+    std::string printerName;
+    if (opt.Has("printer") && opt.Get("printer").IsString())
+        printerName = opt.Get("printer").As<Napi::String>().Utf8Value();
+
+    std::string type = "RAW";
+    if (opt.Has("type") && opt.Get("type").IsString())
+        type = opt.Get("type").As<Napi::String>().Utf8Value();
+
+    auto session = PrintStreamSession::Start(env, printerName, type, ParseStringMap(opt, "options"));
+
+    Napi::Object handle = Napi::Object::New(env);
+
+    handle.Set("write", Napi::Function::New(env, [session](const Napi::CallbackInfo &info)
+    {
+        auto env = info.Env();
+        if (info.Length() < 1 || !info[0].IsBuffer())
+            Napi::TypeError::New(env, "write(buffer, callback)").ThrowAsJavaScriptException();
+
+        auto chunk = info[0].As<Napi::Buffer<uint8_t>>();
+
+        auto op = new PrintStreamSession::Op();
+        op->kind = PrintStreamSession::Op::WRITE;
+        op->data.data = chunk.Data();
+        op->data.size = chunk.Length();
+        op->chunkRef = Napi::Persistent(chunk.As<Napi::Object>());
+        if (info.Length() >= 2 && info[1].IsFunction())
+            op->callback = Napi::Persistent(info[1].As<Napi::Function>());
+
+        if (!session->Push(op) && info.Length() >= 2 && info[1].IsFunction())
+            info[1].As<Napi::Function>().Call({ Napi::Error::New(env, "Print stream is closed").Value() });
+    }));
+
+    handle.Set("end", Napi::Function::New(env, [session](const Napi::CallbackInfo &info)
+    {
+        auto env = info.Env();
+
+        auto op = new PrintStreamSession::Op();
+        op->kind = PrintStreamSession::Op::FINISH;
+        if (info.Length() >= 1 && info[0].IsFunction())
+            op->callback = Napi::Persistent(info[0].As<Napi::Function>());
+
+        if (!session->Push(op) && info.Length() >= 1 && info[0].IsFunction())
+            info[0].As<Napi::Function>().Call({ Napi::Error::New(env, "Print stream is closed").Value() });
+    }));
+
+    handle.Set("abort", Napi::Function::New(env, [session](const Napi::CallbackInfo &)
+    {
+        session->Abort();
+    }));
+
+    // Dropped without end() or abort(): give the job and connection back
+    handle.AddFinalizer(
+        [](Napi::Env, std::weak_ptr<PrintStreamSession> *weak)
+        {
+            if (auto s = weak->lock())
+                s->Abort();
+            delete weak;
+        },
+        new std::weak_ptr<PrintStreamSession>(session));
+
+    return handle;
+}
@@ -0,0 +1,198 @@
+#include "print_coalescer.h"
+#include "printer_service.h"
+
+#include <algorithm>
+
+/* =========================================================
+   Batch task
+========================================================= */
+
+class PrintCoalescer::BatchTask : public PrintTask
+{
+public:
+    BatchTask(PrintCoalescer &owner, std::shared_ptr<Batch> batch)
+        : owner(owner), batch(std::move(batch))
+    {}
+
+    void Run() override
+    {
+        auto documents = owner.TakeWhenClosed(batch);
+        owner.Print(batch->printerName, std::move(documents));
+        owner.executor.Discharge(batch->printerName, batch->chargedJobs, batch->chargedBytes);
+    }
+
+private:
+    PrintCoalescer &owner;
+    std::shared_ptr<Batch> batch;
+};
+
+/* =========================================================
+   PrintCoalescer
+========================================================= */
+
+PrintCoalescer::PrintCoalescer(PrinterService &service, PrintExecutor &executor)
+    : service(service), executor(executor)
+{
+}
+
+PrintCoalescer::~PrintCoalescer()
+{
+    Clear();
+}
+
+void PrintCoalescer::Configure(const CoalescingConfig &newConfig)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    config = newConfig;
+    config.maxJobs = std::max<size_t>(config.maxJobs, 1);
+
+    // Switching off: open batches still print but take no more documents.
+    if (!config.enabled)
+    {
+        for (auto &kv : open)
+            kv.second->closed = true;
+        open.clear();
+        cv.notify_all();
+    }
+}
+
+CoalescingConfig PrintCoalescer::Config()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return config;
+}
+
+bool PrintCoalescer::Accepts(size_t bytes)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return config.enabled && bytes <= config.maxDocumentBytes;
+}
+
+void PrintCoalescer::CloseLocked(const std::shared_ptr<Batch> &batch)
+{
+    batch->closed = true;
+
+    auto it = open.find(batch->printerName);
+    if (it != open.end() && it->second == batch)
+        open.erase(it);
+
+    cv.notify_all();
+}
+
+PrintExecutor::Admission PrintCoalescer::Add(const std::string &printerName,
+                                             std::unique_ptr<CoalescedDocument> document,
+                                             bool waitIfFull)
+{
+    size_t size = document->Data().size;
+
+    // Held across Submit so nobody joins a batch the executor turns away.
+    // The executor never calls back into the coalescer under its own lock.
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto it = open.find(printerName);
+    if (it != open.end() && it->second->bytes + size <= config.maxBytes &&
+        executor.Charge(printerName, size))
+    {
+        Batch &b = *it->second;
+        b.documents.push_back(std::move(document));
+        b.bytes += size;
+        b.chargedJobs++;
+        b.chargedBytes += size;
+        if (b.documents.size() >= config.maxJobs)
+            CloseLocked(it->second);
+        return PrintExecutor::Admission::Queued;
+    }
+
+    if (it != open.end())
+        CloseLocked(it->second);
+
+    auto batch = std::make_shared<Batch>();
+    batch->printerName = printerName;
+    batch->openedAt = std::chrono::steady_clock::now();
+    batch->bytes = size;
+    batch->documents.push_back(std::move(document));
+
+    PrintTaskOptions options;
+    options.bytes = size;
+    options.waitIfFull = waitIfFull;
+
+    auto admission = executor.Submit(printerName,
+                                     std::unique_ptr<PrintTask>(new BatchTask(*this, batch)),
+                                     options);
+
+    if (admission == PrintExecutor::Admission::Queued || admission == PrintExecutor::Admission::Waiting)
+    {
+        if (config.maxJobs > 1)
+            open[printerName] = batch;
+        else
+            batch->closed = true;
+    }
+    return admission;
+}
+
+std::vector<std::unique_ptr<CoalescedDocument>> PrintCoalescer::TakeWhenClosed(const std::shared_ptr<Batch> &batch)
+{
+    std::unique_lock<std::mutex> lock(mu);
+
+    cv.wait_until(lock, batch->openedAt + config.window, [&batch]() { return batch->closed; });
+    CloseLocked(batch);
+
+    return std::move(batch->documents);
+}
+
+void PrintCoalescer::Print(const std::string &printerName, std::vector<std::unique_ptr<CoalescedDocument>> documents)
+{
+    if (documents.empty())
+        return;
+
+    LastTimeout() = TimeoutKind::None;
+    std::string usePrinter = service.ResolvePrinter(printerName);
+
+    if (documents.size() == 1)
+    {
+        int jobId = 0;
+        try
+        {
+            jobId = service.Backend().PrintDirect(usePrinter, documents[0]->Data(), "RAW", StringMap(), PrintControl());
+        }
+        catch (...)
+        {
+        }
+        documents[0]->Complete(jobId, jobId > 0 ? "" : "Print failed", LastTimeout());
+        return;
+    }
+
+    std::vector<BatchDocumentNative> batchDocs(documents.size());
+    for (size_t i = 0; i < documents.size(); i++)
+        batchDocs[i].data = documents[i]->Data();
+
+    BatchResultNative result;
+    try
+    {
+        result = service.Backend().PrintBatch(usePrinter, batchDocs, StringMap());
+    }
+    catch (...)
+    {
+        result = BatchResultNative();
+    }
+
+    for (size_t i = 0; i < documents.size(); i++)
+    {
+        int jobId = i < result.documentJobIds.size() ? result.documentJobIds[i] : result.jobId;
+        std::string error = i < result.documentErrors.size() ? result.documentErrors[i] : "";
+
+        if (jobId <= 0 && error.empty())
+            error = "Print failed";
+
+        documents[i]->Complete(jobId, error, jobId > 0 ? TimeoutKind::None : LastTimeout());
+    }
+}
+
+void PrintCoalescer::Clear()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    for (auto &kv : open)
+        kv.second->closed = true;
+    open.clear();
+    cv.notify_all();
+}
@@ -0,0 +1,103 @@
+#ifndef PRINT_COALESCER_H
+#define PRINT_COALESCER_H
+
+#include "printer_interface.h"
+#include "print_executor.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class PrinterService;
+
+// One caller's document inside a coalesced job
+class CoalescedDocument
+{
+public:
+    virtual ~CoalescedDocument() = default;
+
+    // Must stay valid until Complete
+    virtual ByteSpan Data() const = 0;
+
+    // Called once from the worker; error is empty when the document was
+    // sent. `timeout` says which limit ran out when the job failed on one.
+    virtual void Complete(int jobId, const std::string &error, TimeoutKind timeout) = 0;
+};
+
+struct CoalescingConfig
+{
+    bool enabled = false;
+    std::chrono::milliseconds window{10}; // how long a batch stays open
+    size_t maxJobs = 32;                  // documents per batch
+    size_t maxBytes = 64 * 1024;          // payload per batch
+    size_t maxDocumentBytes = 4096;       // larger payloads print on their own
+};
+
+/*
+  Merges small RAW submissions to one printer into a single
+  multi-document job (see PrinterInterface::PrintBatch).
+
+  The first document for a printer opens a batch and queues one task on
+  the executor; later documents join it until the window since it opened
+  has passed, the batch is full, or the task starts running. A task that
+  starts early waits out the rest of the window on its worker. The batch
+  is admitted by the executor as its first document; every document that
+  joins is charged against the executor's limits too (released when the
+  batch has printed), and one that does not fit closes the batch and is
+  submitted on its own.
+*/
+class PrintCoalescer
+{
+public:
+    PrintCoalescer(PrinterService &service, PrintExecutor &executor);
+    ~PrintCoalescer();
+
+    PrintCoalescer(const PrintCoalescer &) = delete;
+    PrintCoalescer &operator=(const PrintCoalescer &) = delete;
+
+    void Configure(const CoalescingConfig &config);
+    CoalescingConfig Config();
+
+    // False when the document should be submitted on its own
+    bool Accepts(size_t bytes);
+
+    // The document is dropped on Full / Stopped.
+    PrintExecutor::Admission Add(const std::string &printerName,
+                                 std::unique_ptr<CoalescedDocument> document,
+                                 bool waitIfFull);
+
+    // Drops batches that never reached the executor; after Executor().Stop().
+    void Clear();
+
+private:
+    struct Batch
+    {
+        std::string printerName;
+        std::vector<std::unique_ptr<CoalescedDocument>> documents;
+        size_t bytes = 0;
+        size_t chargedJobs = 0; // joined documents charged to the executor
+        size_t chargedBytes = 0;
+        bool closed = false;
+        std::chrono::steady_clock::time_point openedAt;
+    };
+
+    class BatchTask;
+
+    void CloseLocked(const std::shared_ptr<Batch> &batch);
+    std::vector<std::unique_ptr<CoalescedDocument>> TakeWhenClosed(const std::shared_ptr<Batch> &batch);
+    void Print(const std::string &printerName, std::vector<std::unique_ptr<CoalescedDocument>> documents);
+
+    PrinterService &service;
+    PrintExecutor &executor;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    CoalescingConfig config;
+    std::map<std::string, std::shared_ptr<Batch>> open; // by printer name
+};
+
+#endif
@@ -0,0 +1,569 @@
+#include "print_executor.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+constexpr std::chrono::milliseconds PrintExecutor::kAgingStep;
+
+PrintExecutor::PrintExecutor(size_t threads)
+    : threadCount(std::max<size_t>(threads, 1))
+{
+}
+
+PrintExecutor::~PrintExecutor()
+{
+    Stop();
+}
+
+/* =========================================================
+   Admission
+========================================================= */
+
+// Room for one more job of `size` bytes, globally and on queue q (may be
+// null). An oversized job fits once its scope is empty.
+bool PrintExecutor::FitsLocked(const Queue *q, size_t size) const
+{
+    size_t qJobs = q ? q->tasks.size() + (q->running ? 1 : 0) + q->charged : 0;
+    size_t qBytes = q ? q->bytes : 0;
+
+    if (limits.maxJobs && jobs >= limits.maxJobs)
+        return false;
+    if (limits.maxBytes && jobs > 0 && bytes + size > limits.maxBytes)
+        return false;
+    if (limits.maxJobsPerPrinter && qJobs >= limits.maxJobsPerPrinter)
+        return false;
+    if (limits.maxBytesPerPrinter && qJobs > 0 && qBytes + size > limits.maxBytesPerPrinter)
+        return false;
+
+    return true;
+}
+
+void PrintExecutor::EnqueueLocked(const std::string &key, Item item)
+{
+    Queue &q = queues[key];
+    q.bytes += item.bytes;
+    jobs++;
+    bytes += item.bytes;
+    q.tasks.push_back(std::move(item));
+
+    // A queue sits in `ready` while it has tasks and nobody is running one.
+    if (!q.running && q.tasks.size() == 1)
+    {
+        ready.push_back(key);
+        cv.notify_one();
+    }
+
+    SpawnLocked();
+}
+
+void PrintExecutor::AdmitWaitersLocked()
+{
+    // Skip a printer after its first waiter that does not fit, so its
+    // jobs keep their order; other printers may still go ahead.
+    std::unordered_set<std::string> blocked;
+
+    for (auto it = waiters.begin(); it != waiters.end();)
+    {
+        if (limits.maxJobs && jobs >= limits.maxJobs)
+            break;
+
+        if (blocked.count(it->key))
+        {
+            ++it;
+            continue;
+        }
+
+        Queue &q = queues[it->key];
+        if (!FitsLocked(&q, it->item.bytes))
+        {
+            blocked.insert(it->key);
+            ++it;
+            continue;
+        }
+
+        q.waiting--;
+        EnqueueLocked(it->key, std::move(it->item));
+        it = waiters.erase(it);
+    }
+}
+
+PrintExecutor::Admission PrintExecutor::Submit(const std::string &queueKey,
+                                               std::unique_ptr<PrintTask> task,
+                                               const PrintTaskOptions &options)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    if (stopping)
+        return Admission::Stopped;
+
+    auto found = queues.find(queueKey);
+    Queue *q = found == queues.end() ? nullptr : &found->second;
+    bool admit = (!q || q->waiting == 0) && FitsLocked(q, options.bytes);
+
+    if (!admit && !options.waitIfFull)
+    {
+        rejected++;
+        return Admission::Full;
+    }
+
+    Item item;
+    item.task = std::move(task);
+    item.bytes = options.bytes;
+    item.priority = std::min(std::max(options.priority, 1), 100);
+    item.deadline = options.deadline;
+    item.submittedAt = Clock::now();
+    item.seq = nextSeq++;
+
+    if (item.deadline != Clock::time_point::max())
+    {
+        withDeadline++;
+        cv.notify_one(); // an idle worker re-arms its deadline wait
+    }
+
+    // Parked jobs for this printer go first.
+    if (admit)
+    {
+        EnqueueLocked(queueKey, std::move(item));
+        return Admission::Queued;
+    }
+
+    queues[queueKey].waiting++;
+    waiters.push_back(Waiter{ queueKey, std::move(item) });
+    return Admission::Waiting;
+}
+
+bool PrintExecutor::Charge(const std::string &queueKey, size_t size)
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto found = queues.find(queueKey);
+    if (stopping || found == queues.end())
+        return false;
+
+    Queue &q = found->second;
+    if (q.waiting > 0 || !FitsLocked(&q, size))
+        return false;
+
+    q.charged++;
+    q.bytes += size;
+    jobs++;
+    bytes += size;
+    return true;
+}
+
+void PrintExecutor::Discharge(const std::string &queueKey, size_t count, size_t size)
+{
+    if (count == 0 && size == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto found = queues.find(queueKey);
+    if (found == queues.end())
+        return;
+
+    Queue &q = found->second;
+    q.charged -= count;
+    q.bytes -= size;
+    jobs -= count;
+    bytes -= size;
+    AdmitWaitersLocked();
+    ForgetIfIdleLocked(queueKey);
+}
+
+/* =========================================================
+   Scheduling
+========================================================= */
+
+// Index of the task to run next on q: highest aged priority, then
+// earliest deadline, then submission order.
+size_t PrintExecutor::PickLocked(const Queue &q, Clock::time_point now) const
+{
+    auto aged = [now](const Item &item)
+    {
+        return (int64_t)item.priority + (int64_t)((now - item.submittedAt) / kAgingStep);
+    };
+
+    size_t best = 0;
+    int64_t bestScore = aged(q.tasks[0]);
+    for (size_t i = 1; i < q.tasks.size(); i++)
+    {
+        const Item &a = q.tasks[i];
+        const Item &b = q.tasks[best];
+        int64_t score = aged(a);
+
+        if (score > bestScore ||
+            (score == bestScore && (a.deadline < b.deadline ||
+                                    (a.deadline == b.deadline && a.seq < b.seq))))
+        {
+            best = i;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+void PrintExecutor::ForgetIfIdleLocked(const std::string &key)
+{
+    auto it = queues.find(key);
+    if (it == queues.end() || it->second.running)
+        return;
+
+    if (it->second.tasks.empty())
+        ready.erase(std::remove(ready.begin(), ready.end(), key), ready.end());
+
+    if (it->second.tasks.empty() && it->second.waiting == 0 && it->second.charged == 0)
+        queues.erase(it);
+}
+
+// Moves tasks whose deadline has passed into `out` and returns the next
+// pending deadline (max if none).
+PrintExecutor::Clock::time_point PrintExecutor::ExpireLocked(Clock::time_point now,
+                                                              std::vector<std::unique_ptr<PrintTask>> &out)
+{
+    Clock::time_point next = Clock::time_point::max();
+    if (withDeadline == 0)
+        return next;
+
+    std::vector<std::string> touched;
+
+    for (auto &kv : queues)
+    {
+        Queue &q = kv.second;
+        for (auto it = q.tasks.begin(); it != q.tasks.end();)
+        {
+            if (it->deadline > now)
+            {
+                next = std::min(next, it->deadline);
+                ++it;
+                continue;
+            }
+
+            withDeadline--;
+            expired++;
+            jobs--;
+            bytes -= it->bytes;
+            q.bytes -= it->bytes;
+            out.push_back(std::move(it->task));
+            it = q.tasks.erase(it);
+            touched.push_back(kv.first);
+        }
+    }
+
+    for (auto it = waiters.begin(); it != waiters.end();)
+    {
+        if (it->item.deadline > now)
+        {
+            next = std::min(next, it->item.deadline);
+            ++it;
+            continue;
+        }
+
+        withDeadline--;
+        expired++;
+        queues[it->key].waiting--;
+        touched.push_back(it->key);
+        out.push_back(std::move(it->item.task));
+        it = waiters.erase(it);
+    }
+
+    for (auto &key : touched)
+        ForgetIfIdleLocked(key);
+
+    if (!touched.empty())
+        AdmitWaitersLocked();
+
+    return next;
+}
+
+void PrintExecutor::PurgeCancelled()
+{
+    std::vector<std::unique_ptr<PrintTask>> removed;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        std::vector<std::string> touched;
+
+        for (auto &kv : queues)
+        {
+            Queue &q = kv.second;
+            for (auto it = q.tasks.begin(); it != q.tasks.end();)
+            {
+                if (!it->task->Cancelled())
+                {
+                    ++it;
+                    continue;
+                }
+
+                if (it->deadline != Clock::time_point::max())
+                    withDeadline--;
+                cancelled++;
+                jobs--;
+                bytes -= it->bytes;
+                q.bytes -= it->bytes;
+                removed.push_back(std::move(it->task));
+                it = q.tasks.erase(it);
+                touched.push_back(kv.first);
+            }
+        }
+
+        for (auto it = waiters.begin(); it != waiters.end();)
+        {
+            if (!it->item.task->Cancelled())
+            {
+                ++it;
+                continue;
+            }
+
+            if (it->item.deadline != Clock::time_point::max())
+                withDeadline--;
+            cancelled++;
+            queues[it->key].waiting--;
+            touched.push_back(it->key);
+            removed.push_back(std::move(it->item.task));
+            it = waiters.erase(it);
+        }
+
+        for (auto &key : touched)
+            ForgetIfIdleLocked(key);
+
+        if (!touched.empty())
+            AdmitWaitersLocked();
+    }
+
+    for (auto &task : removed)
+    {
+        try
+        {
+            task->Cancel();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+/* =========================================================
+   Workers
+========================================================= */
+
+void PrintExecutor::SpawnLocked()
+{
+    while (!stopping && live < threadCount)
+    {
+        live++;
+        workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+void PrintExecutor::ReapLocked(std::vector<std::thread> &out)
+{
+    for (auto id : exited)
+    {
+        auto it = std::find_if(workers.begin(), workers.end(),
+            [id](const std::thread &t) { return t.get_id() == id; });
+        if (it != workers.end())
+        {
+            out.push_back(std::move(*it));
+            workers.erase(it);
+        }
+    }
+    exited.clear();
+}
+
+void PrintExecutor::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(mu);
+
+    for (;;)
+    {
+        std::vector<std::unique_ptr<PrintTask>> expiredTasks;
+        Clock::time_point nextDeadline = ExpireLocked(Clock::now(), expiredTasks);
+        if (!expiredTasks.empty())
+        {
+            lock.unlock();
+            for (auto &task : expiredTasks)
+            {
+                try
+                {
+                    task->Expire();
+                }
+                catch (...)
+                {
+                }
+            }
+            expiredTasks.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (stopping || live > threadCount)
+        {
+            live--;
+            exited.push_back(std::this_thread::get_id());
+            return;
+        }
+
+        if (ready.empty())
+        {
+            if (nextDeadline == Clock::time_point::max())
+                cv.wait(lock);
+            else
+                cv.wait_until(lock, nextDeadline);
+            continue;
+        }
+
+        std::string key = std::move(ready.front());
+        ready.pop_front();
+
+        Clock::time_point now = Clock::now();
+        Queue &q = queues[key];
+        size_t pick = PickLocked(q, now);
+        Item item = std::move(q.tasks[pick]);
+        q.tasks.erase(q.tasks.begin() + pick);
+        q.running = true;
+        running++;
+
+        if (item.deadline != Clock::time_point::max())
+            withDeadline--;
+
+        auto &latency = waitLatency[item.priority];
+        double waitedMs = std::chrono::duration<double, std::milli>(now - item.submittedAt).count();
+        latency.count++;
+        latency.totalMs += waitedMs;
+        latency.maxMs = std::max(latency.maxMs, waitedMs);
+
+        lock.unlock();
+        try
+        {
+            item.task->Run();
+        }
+        catch (...)
+        {
+            // Tasks report their own failures; keep the thread alive.
+        }
+        item.task.reset();
+        lock.lock();
+
+        // Map nodes are stable, and a queue with a running task is only
+        // erased here, by the worker that owns the running slot.
+        q.running = false;
+        q.bytes -= item.bytes;
+        running--;
+        jobs--;
+        bytes -= item.bytes;
+
+        if (!q.tasks.empty())
+        {
+            ready.push_back(key);
+            cv.notify_one();
+        }
+
+        // After the re-queue above: a waiter admitted onto this printer's
+        // empty queue puts it back in `ready` itself.
+        AdmitWaitersLocked();
+
+        if (q.tasks.empty() && q.waiting == 0 && q.charged == 0)
+            queues.erase(key);
+    }
+}
+
+/* =========================================================
+   Configuration
+========================================================= */
+
+void PrintExecutor::SetThreadCount(size_t threads)
+{
+    std::vector<std::thread> finished;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        threadCount = std::max<size_t>(threads, 1);
+        ReapLocked(finished);
+
+        // Grow right away only if work is already flowing.
+        if (live > 0 || !queues.empty())
+            SpawnLocked();
+    }
+    cv.notify_all();
+
+    for (auto &t : finished)
+        t.join();
+}
+
+size_t PrintExecutor::GetThreadCount()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return threadCount;
+}
+
+void PrintExecutor::SetLimits(const PrintQueueLimits &newLimits)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    limits = newLimits;
+    AdmitWaitersLocked();
+}
+
+PrintQueueStatsNative PrintExecutor::Stats()
+{
+    std::lock_guard<std::mutex> lock(mu);
+
+    PrintQueueStatsNative s;
+    s.jobs = jobs;
+    s.running = running;
+    s.bytes = bytes;
+    s.waiting = waiters.size();
+    s.rejected = rejected;
+    s.expired = expired;
+    s.cancelled = cancelled;
+    s.limits = limits;
+    s.waitLatency = waitLatency;
+
+    for (auto &kv : queues)
+    {
+        PrintQueueStatsNative::Printer p;
+        p.name = kv.first;
+        p.jobs = kv.second.tasks.size() + (kv.second.running ? 1 : 0) + kv.second.charged;
+        p.bytes = kv.second.bytes;
+        p.waiting = kv.second.waiting;
+        s.printers.push_back(std::move(p));
+    }
+    return s;
+}
+
+// Must not be called from a task.
+void PrintExecutor::Stop()
+{
+    std::vector<std::unique_ptr<PrintTask>> dropped;
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+
+        for (auto &kv : queues)
+        {
+            for (auto &item : kv.second.tasks)
+            {
+                jobs--;
+                bytes -= item.bytes;
+                kv.second.bytes -= item.bytes;
+                dropped.push_back(std::move(item.task));
+            }
+            kv.second.tasks.clear();
+            kv.second.waiting = 0;
+        }
+        for (auto &w : waiters)
+            dropped.push_back(std::move(w.item.task));
+        waiters.clear();
+        ready.clear();
+        withDeadline = 0;
+
+        threads.swap(workers);
+        exited.clear();
+    }
+    cv.notify_all();
+
+    for (auto &t : threads)
+        t.join();
+
+    // Dropped tasks are destroyed outside the lock: their destructors
+    // may release JS-side resources.
+    dropped.clear();
+}
@@ -0,0 +1,209 @@
+#ifndef PRINT_EXECUTOR_H
+#define PRINT_EXECUTOR_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// One unit of work on the print executor. A task dropped before it ran
+// (executor stopped) is destroyed without Run().
+class PrintTask
+{
+public:
+    virtual ~PrintTask() = default;
+    virtual void Run() = 0;
+
+    // Called instead of Run when the deadline passed before it started.
+    virtual void Expire() {}
+
+    // A task that reports true is removed by PurgeCancelled if it has not
+    // started yet, and Cancel is called instead of Run.
+    virtual bool Cancelled() const { return false; }
+    virtual void Cancel() {}
+};
+
+struct PrintTaskOptions
+{
+    static const int kDefaultPriority = 50;
+
+    size_t bytes = 0; // payload memory held until the task finishes
+    bool waitIfFull = false;
+    int priority = kDefaultPriority; // 1 (bulk) .. 100 (urgent)
+
+    // Latest start time; expired tasks never run
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+// Admission limits on jobs queued or running; 0 = unlimited. Bytes are
+// the payload memory a job holds until it finishes.
+struct PrintQueueLimits
+{
+    size_t maxJobs = 0;
+    size_t maxBytes = 0;
+    size_t maxJobsPerPrinter = 0;
+    size_t maxBytesPerPrinter = 0;
+};
+
+struct PrintQueueStatsNative
+{
+    struct Printer
+    {
+        std::string name;
+        size_t jobs = 0; // admitted: queued + running
+        size_t bytes = 0;
+        size_t waiting = 0;
+    };
+
+    // Submit-to-start time of tasks that ran, by priority
+    struct WaitLatency
+    {
+        uint64_t count = 0;
+        double totalMs = 0;
+        double maxMs = 0;
+    };
+
+    size_t jobs = 0;
+    size_t running = 0;
+    size_t bytes = 0;
+    size_t waiting = 0;
+    uint64_t rejected = 0;
+    uint64_t expired = 0;
+    uint64_t cancelled = 0;
+    PrintQueueLimits limits;
+    std::vector<Printer> printers;
+    std::map<int, WaitLatency> waitLatency;
+};
+
+/*
+  Worker threads for blocking print submissions, separate from the libuv
+  threadpool so a burst of jobs cannot starve fs / crypto work.
+
+  Tasks are queued per printer and one printer runs one task at a time,
+  while different printers run in parallel on up to threadCount threads.
+  Threads start on first use.
+
+  Within a printer the highest priority runs first; equal priorities run
+  by earliest deadline, then in submission order. Waiting raises a task's
+  effective priority by one level per kAgingStep, so bulk jobs still get
+  through a steady stream of urgent ones. Deadlines are checked whenever
+  a worker is free; a task that has not started by its deadline is
+  expired instead of run.
+
+  A task is only admitted while the global and per-printer limits have
+  room. Otherwise it is either rejected or parked until earlier jobs
+  finish; parked tasks are admitted in submission order per printer.
+  A job larger than a byte limit is still admitted once nothing else is
+  in flight in that scope.
+*/
+class PrintExecutor
+{
+public:
+    static const size_t kDefaultThreads = 2;
+    static constexpr std::chrono::milliseconds kAgingStep{100};
+
+    enum class Admission { Queued, Waiting, Full, Stopped };
+
+    explicit PrintExecutor(size_t threads = kDefaultThreads);
+    ~PrintExecutor();
+
+    PrintExecutor(const PrintExecutor &) = delete;
+    PrintExecutor &operator=(const PrintExecutor &) = delete;
+
+    // The task is dropped on Full / Stopped.
+    Admission Submit(const std::string &queueKey,
+                     std::unique_ptr<PrintTask> task,
+                     const PrintTaskOptions &options = PrintTaskOptions());
+
+    // Counts one more job of `bytes` on queueKey against the limits, for
+    // work riding on a task already admitted there (a coalesced
+    // document). False, and nothing counted, when the limits have no
+    // room or jobs are parked on the queue. Discharge releases it.
+    bool Charge(const std::string &queueKey, size_t bytes);
+    void Discharge(const std::string &queueKey, size_t jobs, size_t bytes);
+
+    void SetThreadCount(size_t threads);
+    size_t GetThreadCount();
+
+    void SetLimits(const PrintQueueLimits &limits);
+    PrintQueueStatsNative Stats();
+
+    // Removes queued and parked tasks whose Cancelled() is true and calls
+    // their Cancel() on this thread. Running tasks watch for it themselves.
+    void PurgeCancelled();
+
+    // Drops queued and parked tasks and waits for running ones.
+    void Stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Item
+    {
+        std::unique_ptr<PrintTask> task;
+        size_t bytes = 0;
+        int priority = PrintTaskOptions::kDefaultPriority;
+        Clock::time_point deadline = Clock::time_point::max();
+        Clock::time_point submittedAt;
+        uint64_t seq = 0;
+    };
+
+    struct Waiter
+    {
+        std::string key;
+        Item item;
+    };
+
+    struct Queue
+    {
+        std::deque<Item> tasks;
+        bool running = false;
+        size_t bytes = 0;   // admitted tasks, including the running one
+        size_t waiting = 0; // parked in `waiters`
+        size_t charged = 0; // jobs counted through Charge
+    };
+
+    void WorkerLoop();
+    void SpawnLocked();
+    void ReapLocked(std::vector<std::thread> &out);
+
+    bool FitsLocked(const Queue *q, size_t bytes) const;
+    void EnqueueLocked(const std::string &key, Item item);
+    void AdmitWaitersLocked();
+
+    size_t PickLocked(const Queue &q, Clock::time_point now) const;
+    Clock::time_point ExpireLocked(Clock::time_point now, std::vector<std::unique_ptr<PrintTask>> &out);
+    void ForgetIfIdleLocked(const std::string &key);
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::unordered_map<std::string, Queue> queues;
+    std::deque<std::string> ready; // queues with tasks and no running task
+    std::deque<Waiter> waiters;
+
+    PrintQueueLimits limits;
+    size_t jobs = 0;
+    size_t running = 0;
+    size_t bytes = 0;
+    uint64_t rejected = 0;
+    uint64_t expired = 0;
+    uint64_t cancelled = 0;
+    uint64_t nextSeq = 0;
+    size_t withDeadline = 0; // queued or parked tasks with a deadline
+    std::map<int, PrintQueueStatsNative::WaitLatency> waitLatency;
+
+    std::vector<std::thread> workers;
+    std::vector<std::thread::id> exited;
+    size_t threadCount;
+    size_t live = 0;
+    bool stopping = false;
+};
+
+#endif
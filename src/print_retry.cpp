@@ -0,0 +1,82 @@
+#include "print_retry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <thread>
+
+std::string JobNameForKey(const std::string &idempotencyKey)
+{
+    return "Node Print Job [" + idempotencyKey + "]";
+}
+
+// Sleeps before retry number `retry` (0-based); false if cancelled meanwhile.
+static bool Backoff(const RetryPolicy &policy, unsigned retry, const PrintControl &control)
+{
+    static thread_local std::mt19937 rng(std::random_device{}());
+
+    double delay = policy.baseDelayMs * std::pow(2.0, (double)std::min(retry, 20u));
+    delay = std::min(delay, (double)policy.maxDelayMs);
+
+    double jitter = std::min(std::max(policy.jitter, 0.0), 1.0);
+    delay -= delay * jitter * std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds((int64_t)delay);
+    while (std::chrono::steady_clock::now() < until)
+    {
+        if (control.Cancelled())
+            return false;
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            until - std::chrono::steady_clock::now(), std::chrono::milliseconds(50)));
+    }
+    return !control.Cancelled();
+}
+
+int SubmitWithRetry(PrinterInterface &backend,
+                    const std::string &printerName,
+                    const RetryPolicy &policy,
+                    const std::string &idempotencyKey,
+                    const PrintControl &control,
+                    const std::function<int(const PrintControl &)> &attempt)
+{
+    PrintControl c = control;
+    if (!idempotencyKey.empty())
+        c.jobName = JobNameForKey(idempotencyKey);
+
+    for (unsigned n = 0;; n++)
+    {
+        LastTimeout() = TimeoutKind::None;
+        LastSubmitFailure() = SubmitFailure::None;
+
+        // Also before the first attempt: an earlier call may have
+        // submitted the job and failed afterwards
+        int jobId = 0;
+        int existing = idempotencyKey.empty() ? 0 : backend.FindJobByName(printerName, c.jobName);
+
+        if (existing > 0)
+            return existing;
+
+        if (existing < 0)
+        {
+            if (LastTimeout() == TimeoutKind::None)
+                LastSubmitFailure() = SubmitFailure::Transient;
+        }
+        else
+        {
+            jobId = attempt(c);
+            if (jobId > 0)
+                return jobId;
+        }
+
+        SubmitFailure failure = LastSubmitFailure();
+        bool retryable = failure == SubmitFailure::Transient ||
+                         (failure == SubmitFailure::TransientJobMayExist && !idempotencyKey.empty());
+
+        if (!retryable || n >= policy.retries || LastTimeout() != TimeoutKind::None || c.Cancelled())
+            return 0;
+
+        if (!Backoff(policy, n, c))
+            return 0;
+    }
+}
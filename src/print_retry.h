@@ -0,0 +1,43 @@
+#ifndef PRINT_RETRY_H
+#define PRINT_RETRY_H
+
+#include "printer_interface.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+struct RetryPolicy
+{
+    unsigned retries = 2;        // attempts after the first
+    uint32_t baseDelayMs = 250;  // doubled per retry
+    uint32_t maxDelayMs = 4000;
+    double jitter = 0.5;         // fraction of each delay drawn at random
+};
+
+// The job name that carries an idempotency key
+std::string JobNameForKey(const std::string &idempotencyKey);
+
+/*
+  Runs a submission, retrying failures the backend classified as
+  transient (LastSubmitFailure) with exponential backoff and jitter.
+
+  Without an idempotency key only failures that cannot have left a job
+  behind are retried. With one, the job is named after the key and the
+  backend is asked for a fully submitted job of that name before every
+  attempt, the first included, so a retry or a later call with the same
+  key returns the job submitted earlier instead of printing twice (and
+  half-created ones are cancelled). A failed lookup counts as a
+  transient failure of that attempt.
+
+  Timeouts and cancellation are never retried; the backoff wait ends
+  early on cancellation.
+*/
+int SubmitWithRetry(PrinterInterface &backend,
+                    const std::string &printerName,
+                    const RetryPolicy &policy,
+                    const std::string &idempotencyKey,
+                    const PrintControl &control,
+                    const std::function<int(const PrintControl &)> &attempt);
+
+#endif
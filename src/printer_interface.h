@@ -4,12 +4,83 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <memory>
+#include <functional>
 #include <cstdint>
 #include <ctime>
+#include <atomic>
 
 using StringMap = std::map<std::string, std::string>;
 using DriverOptions = std::map<std::string, std::map<std::string, bool>>;
 
+// Non-owning view of caller-owned bytes, valid for the duration of the call
+struct ByteSpan {
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+};
+
+// Time limits for one backend call in ms; 0 = the backend's default.
+// connect bounds opening a connection, read bounds each wait for the
+// server, total bounds the whole call.
+struct CallTimeouts {
+    uint32_t connectMs = 0;
+    uint32_t readMs = 0;
+    uint32_t totalMs = 0;
+};
+
+enum class TimeoutKind { None, Connect, Read, Total };
+
+// Why the last backend call on this thread gave up, like cupsLastError().
+// Callers reset it before a call and check it when the call fails.
+inline TimeoutKind &LastTimeout()
+{
+    static thread_local TimeoutKind kind = TimeoutKind::None;
+    return kind;
+}
+
+// How the last failed submission on this thread failed, set by backends
+// that can tell. Transient failures (server restarting or busy, connection
+// reset) are worth retrying; when the job may have been created first,
+// only after checking that it does not exist.
+enum class SubmitFailure { None, Permanent, Transient, TransientJobMayExist };
+
+inline SubmitFailure &LastSubmitFailure()
+{
+    static thread_local SubmitFailure failure = SubmitFailure::None;
+    return failure;
+}
+
+// Whether the last GetJob / GetJobs call on this thread failed (no
+// connection, server error) rather than finding nothing. Callers reset
+// it before the call.
+inline bool &LastQueryFailed()
+{
+    static thread_local bool failed = false;
+    return failed;
+}
+
+// Per-submission hooks supplied by the caller; every member is optional.
+struct PrintControl {
+    // Called from the submitting thread as bytes reach the server
+    std::function<void(uint64_t bytesSent, uint64_t totalBytes)> onProgress;
+
+    // IPP job-priority, 1 (lowest) .. 100; 0 = server default
+    int priority = 0;
+
+    // Set from another thread to stop the upload between chunks; a job
+    // already created is cancelled and the call returns 0.
+    const std::atomic<bool> *cancelled = nullptr;
+
+    bool Cancelled() const { return cancelled && cancelled->load(); }
+
+    // Overrides the backend's timeouts for this submission
+    CallTimeouts timeouts;
+
+    // job-name / document name; empty = "Node Print Job"
+    std::string jobName;
+};
+
 struct PrinterDetailsNative {
     std::string name;
     bool isDefault = false;
@@ -31,37 +102,274 @@ struct JobDetailsNative {
     std::time_t processingTime = 0;
 };
 
+// Which parts of a listed JobDetailsNative to fill (bit mask); id,
+// printerName and status are always filled.
+enum JobField : unsigned {
+    JOB_NAME = 1u << 0,
+    JOB_USER = 1u << 1,
+    JOB_FORMAT = 1u << 2,
+    JOB_PRIORITY = 1u << 3,
+    JOB_SIZE = 1u << 4,
+    JOB_TIMES = 1u << 5, // creation, processing and completed
+    JOB_ALL = JOB_NAME | JOB_USER | JOB_FORMAT | JOB_PRIORITY | JOB_SIZE | JOB_TIMES
+};
+
+enum class JobWhich { Active, Completed, All };
+
+struct JobQueryNative {
+    JobWhich which = JobWhich::Active;
+    int limit = 0;      // 0 = no limit
+    int firstJobId = 0; // only jobs with this id or above
+    std::string user;   // empty = every user
+    unsigned fields = JOB_ALL;
+
+    // For backends that filter on their side
+    bool Matches(const JobDetailsNative &j) const
+    {
+        return j.id >= firstJobId && (user.empty() || j.user == user);
+    }
+};
+
+// One document of a multi-document job
+struct BatchDocumentNative {
+    ByteSpan data;
+    std::string type = "RAW";
+    std::string name; // document-name, optional
+};
+
+struct BatchResultNative {
+    int jobId = 0;                           // 0 when no job could be created
+    std::vector<std::string> documentErrors; // per document, empty = sent
+    std::vector<int> documentJobIds;         // per document when each went as its own job
+};
+
+// Which parts of a PrinterSnapshotNative to fill (bit mask)
+enum PrinterSnapshotField : unsigned {
+    SNAPSHOT_DETAILS = 1u << 0,
+    SNAPSHOT_DRIVER_OPTIONS = 1u << 1,
+    SNAPSHOT_PAPER_SIZE = 1u << 2,
+    SNAPSHOT_ALL = SNAPSHOT_DETAILS | SNAPSHOT_DRIVER_OPTIONS | SNAPSHOT_PAPER_SIZE
+};
+
+struct PrinterSnapshotNative {
+    unsigned fields = 0; // fields actually filled
+    PrinterDetailsNative details;
+    DriverOptions driverOptions;
+    std::string paperSize;
+};
+
+struct CacheStatsNative {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+    size_t maxEntries = 0;
+    size_t maxBytes = 0;
+};
+
+// A printer or job event pushed by the server
+struct PrinterEventNative {
+    std::string event; // IPP event keyword, e.g. "job-completed"
+    std::string printerName;
+    int jobId = 0;                   // 0 for printer events
+    std::vector<std::string> status; // JobStatus words, or IDLE / PROCESSING / STOPPED
+    std::string message;             // notify-text, may be empty
+    std::time_t time = 0;
+};
+
+// Events of one server-side subscription, read by a single thread.
+class PrinterEventSourceNative
+{
+public:
+    virtual ~PrinterEventSourceNative() = default;
+
+    // Blocks until events arrive and appends them to `out`. False once
+    // the subscription is lost or Interrupt() was called.
+    virtual bool Next(std::vector<PrinterEventNative> &out) = 0;
+
+    // From any thread: a blocked or later Next() returns false.
+    virtual void Interrupt() = 0;
+};
+
+// One document uploaded incrementally: Write() chunks in order, then
+// Finish() (returns jobId, 0 on failure) or Abort().
+class PrintStreamNative
+{
+public:
+    virtual ~PrintStreamNative() = default;
+
+    virtual bool Write(ByteSpan chunk) = 0;
+    virtual int Finish() = 0;
+    virtual void Abort() = 0;
+};
+
 class PrinterInterface
 {
 public:
     virtual ~PrinterInterface() = default;
 
+    // One backend serves every call for the addon's lifetime, from any
+    // thread. Init runs once before first use; Shutdown releases held
+    // connections and caches when the environment goes away.
+    virtual void Init() {}
+    virtual void Shutdown() {}
+
     // Printers
     virtual std::vector<PrinterDetailsNative> GetPrinters() = 0;
     virtual PrinterDetailsNative GetPrinter(const std::string &printerName) = 0;
     virtual std::string GetDefaultPrinterName() = 0;
 
+    // Opaque token that changes whenever printers are added, deleted or
+    // modified. Empty means the backend cannot tell (TTL-only refresh).
+    virtual std::string GetPrintersChangeStamp() { return std::string(); }
+
     // Driver options & paper
     virtual DriverOptions GetPrinterDriverOptions(const std::string &printerName) = 0;
     virtual std::string GetSelectedPaperSize(const std::string &printerName) = 0;
 
+    // Several of the above in one call. Backends override this to open
+    // each source (destination, PPD) only once.
+    virtual PrinterSnapshotNative GetPrinterSnapshot(const std::string &printerName, unsigned fields)
+    {
+        PrinterSnapshotNative s;
+        if (fields & SNAPSHOT_DETAILS)
+            s.details = GetPrinter(printerName);
+        if (fields & SNAPSHOT_DRIVER_OPTIONS)
+            s.driverOptions = GetPrinterDriverOptions(printerName);
+        if (fields & SNAPSHOT_PAPER_SIZE)
+            s.paperSize = GetSelectedPaperSize(printerName);
+        s.fields = fields & SNAPSHOT_ALL;
+        return s;
+    }
+
+    // Parsed driver capability cache (backends without one report zeros)
+    virtual CacheStatsNative GetCapabilityCacheStats() { return CacheStatsNative(); }
+    virtual void SetCapabilityCacheLimits(size_t maxEntries, size_t maxBytes)
+    {
+        (void)maxEntries;
+        (void)maxBytes;
+    }
+
+    // Default limits for every call. Backends that cannot bound their
+    // calls ignore this.
+    virtual void SetTimeouts(const CallTimeouts &timeouts) { (void)timeouts; }
+    virtual CallTimeouts GetTimeouts() { return CallTimeouts(); }
+
     // Printing
     // return jobId (>0) or 0 on failure
     virtual int PrintDirect(const std::string &printerName,
-                            const std::vector<uint8_t> &data,
+                            ByteSpan data,
                             const std::string &type,
-                            const StringMap &options) = 0;
+                            const StringMap &options,
+                            const PrintControl &control) = 0;
 
     virtual int PrintFile(const std::string &printerName,
-                          const std::string &filename) = 0;
+                          const std::string &filename,
+                          const PrintControl &control) = 0;
+
+    // All documents in one job where the backend supports it. The default
+    // submits each document as its own job and reports the first job id
+    // (each document's own id in documentJobIds).
+    virtual BatchResultNative PrintBatch(const std::string &printerName,
+                                         const std::vector<BatchDocumentNative> &documents,
+                                         const StringMap &options)
+    {
+        BatchResultNative r;
+        for (auto &doc : documents)
+        {
+            int id = PrintDirect(printerName, doc.data, doc.type, options, PrintControl());
+            if (id > 0 && r.jobId == 0)
+                r.jobId = id;
+            r.documentErrors.push_back(id > 0 ? "" : "Print failed");
+            r.documentJobIds.push_back(id);
+        }
+        return r;
+    }
+
+    // Id of a fully submitted job with this name, live or recently
+    // completed (cancelled and aborted ones don't count); 0 if there is
+    // none, -1 if the lookup failed. Jobs of that name that never got
+    // their document are cancelled. The default cannot look jobs up and
+    // reports none.
+    virtual int FindJobByName(const std::string &printerName, const std::string &jobName)
+    {
+        (void)printerName;
+        (void)jobName;
+        return 0;
+    }
+
+    // nullptr when the job could not be opened. The default buffers the
+    // whole document and submits it through PrintDirect on Finish().
+    virtual std::unique_ptr<PrintStreamNative> OpenPrintStream(const std::string &printerName,
+                                                               const std::string &type,
+                                                               const StringMap &options);
+
+    // Server-pushed events for every printer. SupportsEvents() tells
+    // whether the backend has them at all; OpenEventSource returns
+    // nullptr when the subscription could not be created.
+    virtual bool SupportsEvents() { return false; }
+    virtual std::unique_ptr<PrinterEventSourceNative> OpenEventSource(const std::set<std::string> &events)
+    {
+        (void)events;
+        return nullptr;
+    }
 
     // Capabilities
     virtual std::vector<std::string> GetSupportedPrintFormats() = 0;
 
     // Jobs
     virtual JobDetailsNative GetJob(const std::string &printerName, int jobId) = 0;
+
+    // Jobs in ascending id order; empty printerName lists every printer.
+    virtual std::vector<JobDetailsNative> GetJobs(const std::string &printerName, const JobQueryNative &query) = 0;
     virtual void SetJob(const std::string &printerName, int jobId, const std::string &command) = 0;
     virtual std::vector<std::string> GetSupportedJobCommands() = 0;
 };
 
+/* Fallback stream for backends without incremental upload */
+class BufferedPrintStream : public PrintStreamNative
+{
+public:
+    BufferedPrintStream(PrinterInterface &backend,
+                        std::string printerName,
+                        std::string type,
+                        StringMap options)
+        : backend(backend),
+          printerName(std::move(printerName)),
+          type(std::move(type)),
+          options(std::move(options))
+    {}
+
+    bool Write(ByteSpan chunk) override
+    {
+        buffer.insert(buffer.end(), chunk.data, chunk.data + chunk.size);
+        return true;
+    }
+
+    int Finish() override
+    {
+        return backend.PrintDirect(printerName, ByteSpan{ buffer.data(), buffer.size() }, type, options, PrintControl());
+    }
+
+    void Abort() override
+    {
+        buffer.clear();
+    }
+
+private:
+    PrinterInterface &backend;
+    std::string printerName;
+    std::string type;
+    StringMap options;
+    std::vector<uint8_t> buffer;
+};
+
+inline std::unique_ptr<PrintStreamNative> PrinterInterface::OpenPrintStream(const std::string &printerName,
+                                                                            const std::string &type,
+                                                                            const StringMap &options)
+{
+    return std::unique_ptr<PrintStreamNative>(new BufferedPrintStream(*this, printerName, type, options));
+}
+
 #endif
\ No newline at end of file
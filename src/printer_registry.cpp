@@ -0,0 +1,145 @@
+#include "printer_registry.h"
+
+// The change stamp is cheap, but not free: probe it at most this often.
+static const std::chrono::milliseconds kStampProbeInterval(1000);
+
+/* =========================================================
+   Snapshot maintenance
+========================================================= */
+
+// Called with `loading` set; clears it.
+void PrinterRegistry::Load(PrinterInterface &backend)
+{
+    uint64_t gen;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        gen = generation;
+    }
+
+    // Stamp first: a change that lands while we enumerate is picked up next time.
+    std::string stamp = backend.GetPrintersChangeStamp();
+    std::vector<PrinterDetailsNative> list = backend.GetPrinters();
+
+    std::unordered_map<std::string, size_t> names;
+    std::string def;
+    for (size_t i = 0; i < list.size(); i++)
+    {
+        names[list[i].name] = i;
+        if (list[i].isDefault && def.empty())
+            def = list[i].name;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        changeStamp.swap(stamp);
+        printers.swap(list);
+        byName.swap(names);
+        defaultName.swap(def);
+
+        loadedAt = std::chrono::steady_clock::now();
+        lastProbe = loadedAt;
+        loadedOnce = true;
+        loading = false;
+
+        // Invalidated while enumerating: served, but reloaded next time
+        valid = gen == generation;
+    }
+    loadedCv.notify_all();
+}
+
+void PrinterRegistry::EnsureFresh(PrinterInterface &backend)
+{
+    std::unique_lock<std::mutex> lock(mu);
+    auto now = std::chrono::steady_clock::now();
+
+    if (valid && now - loadedAt < ttl)
+    {
+        if (loading || now - lastProbe < kStampProbeInterval)
+            return;
+        lastProbe = now;
+
+        std::string known = changeStamp;
+        lock.unlock();
+        if (backend.GetPrintersChangeStamp() == known)
+            return;
+        lock.lock();
+    }
+
+    if (loading)
+    {
+        if (!loadedOnce)
+            loadedCv.wait(lock, [this]() { return !loading; });
+        return;
+    }
+
+    loading = true;
+    lock.unlock();
+    Load(backend);
+}
+
+void PrinterRegistry::Refresh(PrinterInterface &backend)
+{
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        loading = true;
+    }
+    Load(backend);
+}
+
+void PrinterRegistry::Invalidate()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    valid = false;
+    generation++;
+}
+
+void PrinterRegistry::SetTtl(std::chrono::milliseconds value)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    ttl = value;
+}
+
+std::chrono::milliseconds PrinterRegistry::GetTtl()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return ttl;
+}
+
+/* =========================================================
+   Lookups
+========================================================= */
+
+std::vector<PrinterDetailsNative> PrinterRegistry::GetPrinters(PrinterInterface &backend)
+{
+    EnsureFresh(backend);
+    std::lock_guard<std::mutex> lock(mu);
+    return printers;
+}
+
+bool PrinterRegistry::FindPrinter(PrinterInterface &backend,
+                                  const std::string &printerName,
+                                  PrinterDetailsNative &out)
+{
+    EnsureFresh(backend);
+    std::lock_guard<std::mutex> lock(mu);
+
+    auto it = byName.find(printerName);
+    if (it == byName.end())
+        return false;
+
+    out = printers[it->second];
+    return true;
+}
+
+std::string PrinterRegistry::GetDefaultPrinterName(PrinterInterface &backend)
+{
+    EnsureFresh(backend);
+    std::lock_guard<std::mutex> lock(mu);
+    return defaultName;
+}
+
+std::string PrinterRegistry::CachedDefaultPrinterName()
+{
+    std::lock_guard<std::mutex> lock(mu);
+    return defaultName;
+}
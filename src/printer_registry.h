@@ -0,0 +1,64 @@
+#ifndef PRINTER_REGISTRY_H
+#define PRINTER_REGISTRY_H
+
+#include "printer_interface.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+  Snapshot of the printer list, owned by the PrinterService.
+
+  The snapshot is rebuilt from the backend when it is older than the TTL,
+  when the backend reports a new change stamp (printer added / deleted /
+  modified), or when Refresh() / Invalidate() is called explicitly.
+  Every other read is a memory lookup.
+
+  The backend is never called with the mutex held: a rebuild enumerates
+  unlocked and swaps the new snapshot in. While one thread rebuilds,
+  others keep reading the previous snapshot, and only wait for it when
+  there is none yet.
+*/
+class PrinterRegistry
+{
+public:
+    std::vector<PrinterDetailsNative> GetPrinters(PrinterInterface &backend);
+    bool FindPrinter(PrinterInterface &backend, const std::string &printerName, PrinterDetailsNative &out);
+    std::string GetDefaultPrinterName(PrinterInterface &backend);
+
+    // The current snapshot's default, without ever calling the backend;
+    // empty before the first load.
+    std::string CachedDefaultPrinterName();
+
+    void Refresh(PrinterInterface &backend);
+    void Invalidate();
+
+    void SetTtl(std::chrono::milliseconds ttl);
+    std::chrono::milliseconds GetTtl();
+
+private:
+    void EnsureFresh(PrinterInterface &backend);
+    void Load(PrinterInterface &backend);
+
+    std::mutex mu;
+    std::condition_variable loadedCv;
+    bool loading = false;
+    bool loadedOnce = false;
+    uint64_t generation = 0; // bumped by Invalidate
+    bool valid = false;
+    std::chrono::milliseconds ttl{5000};
+    std::chrono::steady_clock::time_point loadedAt;
+    std::chrono::steady_clock::time_point lastProbe;
+    std::string changeStamp;
+
+    std::vector<PrinterDetailsNative> printers;
+    std::unordered_map<std::string, size_t> byName;
+    std::string defaultName;
+};
+
+#endif
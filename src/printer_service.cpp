@@ -0,0 +1,124 @@
+#include "printer_service.h"
+#include "printer_factory.h"
+
+// Holds the watcher's subscription open for the registry: the watcher
+// itself invalidates the registry on printer-added / -deleted / -modified.
+class RegistryWatch : public PrinterWatchListener
+{
+public:
+    void OnEvents(const std::vector<PrinterEventNative> &) override {}
+
+    // The registry's TTL covers the time without a subscription
+    void OnError(const std::string &) override {}
+};
+
+PrinterService::PrinterService()
+    : backend(PrinterFactory::Create()),
+      coalescer(*this, executor),
+      watcher(*this),
+      poller(*this)
+{
+}
+
+PrinterService::~PrinterService()
+{
+    Shutdown();
+}
+
+void PrinterService::Init()
+{
+    if (running.exchange(true))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(streamsMu);
+        streamsClosed = false;
+    }
+    backend->Init();
+
+    // Printer changes reach the registry as events whenever the backend
+    // has them, not only while some JS caller watches
+    if (backend->SupportsEvents() && !registryWatch)
+    {
+        PrinterWatchFilter filter;
+        filter.events = { "printer-added", "printer-deleted", "printer-modified" };
+        registryWatch = watcher.Add(filter, std::make_shared<RegistryWatch>());
+    }
+}
+
+void PrinterService::Shutdown()
+{
+    if (!running.exchange(false))
+        return;
+
+    // Jobs still running finish on the backend before it lets go of
+    // its connections; queued ones are dropped. Open streams are
+    // aborted and the event subscription and job polling end first,
+    // while the backend can still reach the server.
+    std::map<uint64_t, std::function<void()>> open;
+    {
+        std::lock_guard<std::mutex> lock(streamsMu);
+        streamsClosed = true;
+        open = streams;
+    }
+    for (auto &kv : open)
+        kv.second();
+    {
+        std::unique_lock<std::mutex> lock(streamsMu);
+        streamsCv.wait(lock, [this]() { return streams.empty(); });
+    }
+
+    watcher.Stop();
+    registryWatch = 0;
+    poller.Stop();
+    executor.Stop();
+    coalescer.Clear();
+    registry.Invalidate();
+    backend->Shutdown();
+}
+
+std::string PrinterService::ResolvePrinter(const std::string &printerName)
+{
+    if (!printerName.empty())
+        return printerName;
+
+    return registry.GetDefaultPrinterName(*backend);
+}
+
+std::string PrinterService::QueueKey(const std::string &printerName)
+{
+    if (!printerName.empty())
+        return printerName;
+
+    return registry.CachedDefaultPrinterName();
+}
+
+uint64_t PrinterService::AddStream(std::function<void()> abort)
+{
+    std::lock_guard<std::mutex> lock(streamsMu);
+    if (streamsClosed)
+        return 0;
+
+    uint64_t id = nextStreamId++;
+    streams[id] = std::move(abort);
+    return id;
+}
+
+void PrinterService::RemoveStream(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(streamsMu);
+    streams.erase(id);
+    streamsCv.notify_all();
+}
+
+void PrinterService::SetRetryPolicy(const RetryPolicy &policy)
+{
+    std::lock_guard<std::mutex> lock(retryMu);
+    retryPolicy = policy;
+}
+
+RetryPolicy PrinterService::GetRetryPolicy()
+{
+    std::lock_guard<std::mutex> lock(retryMu);
+    return retryPolicy;
+}
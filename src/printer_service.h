@@ -0,0 +1,90 @@
+#ifndef PRINTER_SERVICE_H
+#define PRINTER_SERVICE_H
+
+#include "printer_interface.h"
+#include "printer_registry.h"
+#include "print_executor.h"
+#include "print_coalescer.h"
+#include "print_retry.h"
+#include "printer_watcher.h"
+#include "job_poller.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/*
+  The addon's backend: one per Node environment, created when the module
+  loads and shut down when the environment is torn down.
+
+  Everything that should outlive a single call (the platform backend with
+  its connections and caches, the printer registry, the print executor
+  and coalescer, the event watcher, the job poller) lives here.
+  Threadpool workers hold a shared_ptr, so a query still in flight keeps
+  the service alive past Shutdown; executor tasks, open print streams
+  and the watcher and poller threads do not need to, Shutdown aborts or
+  waits for them.
+*/
+class PrinterService
+{
+public:
+    PrinterService();
+    ~PrinterService();
+
+    PrinterService(const PrinterService &) = delete;
+    PrinterService &operator=(const PrinterService &) = delete;
+
+    void Init();
+    void Shutdown();
+
+    PrinterInterface &Backend() { return *backend; }
+    PrinterRegistry &Registry() { return registry; }
+    PrintExecutor &Executor() { return executor; }
+    PrintCoalescer &Coalescer() { return coalescer; }
+    PrinterWatcher &Watcher() { return watcher; }
+    JobPoller &Poller() { return poller; }
+
+    // Empty name = the default printer
+    std::string ResolvePrinter(const std::string &printerName);
+
+    // Executor queue for a printer name, for the JS thread: never calls
+    // the backend, so '' maps to the registry's cached default (or stays
+    // '' before the first load).
+    std::string QueueKey(const std::string &printerName);
+
+    // Open print streams. Shutdown calls every registered abort and waits
+    // until each stream has removed itself; Add returns 0 once shutting
+    // down.
+    uint64_t AddStream(std::function<void()> abort);
+    void RemoveStream(uint64_t id);
+
+    // Applies to printDirect / printFile submissions made after the call
+    void SetRetryPolicy(const RetryPolicy &policy);
+    RetryPolicy GetRetryPolicy();
+
+private:
+    std::unique_ptr<PrinterInterface> backend;
+    PrinterRegistry registry;
+    PrintExecutor executor;
+    PrintCoalescer coalescer;
+    PrinterWatcher watcher;
+    JobPoller poller;
+    std::atomic<bool> running{false};
+    uint64_t registryWatch = 0; // keeps the subscription for registry events open
+
+    std::mutex streamsMu;
+    std::condition_variable streamsCv;
+    std::map<uint64_t, std::function<void()>> streams;
+    uint64_t nextStreamId = 1;
+    bool streamsClosed = false;
+
+    std::mutex retryMu;
+    RetryPolicy retryPolicy;
+};
+
+#endif
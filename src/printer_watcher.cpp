@@ -0,0 +1,262 @@
+#include "printer_watcher.h"
+#include "printer_service.h"
+
+#include <algorithm>
+
+static const char *const kKnownEvents[] = {
+    "job-created",
+    "job-completed",
+    "job-stopped",
+    "job-state-changed",
+    "job-progress",
+    "printer-added",
+    "printer-deleted",
+    "printer-modified",
+    "printer-stopped",
+    "printer-restarted",
+    "printer-shutdown",
+    "printer-state-changed",
+};
+
+// Always subscribed while anyone listens: they invalidate the registry
+static const char *const kRegistryEvents[] = {
+    "printer-added",
+    "printer-deleted",
+    "printer-modified",
+};
+
+constexpr std::chrono::milliseconds PrinterWatcher::kRetryMin;
+constexpr std::chrono::milliseconds PrinterWatcher::kRetryMax;
+
+/* =========================================================
+   PrinterWatchFilter
+========================================================= */
+
+bool PrinterWatchFilter::Matches(const PrinterEventNative &event) const
+{
+    if (!printers.empty() && !printers.count(event.printerName))
+        return false;
+
+    if (events.count(event.event))
+        return true;
+
+    const std::string &e = event.event;
+    if (events.count("job-state-changed") &&
+        (e == "job-created" || e == "job-completed" || e == "job-stopped"))
+        return true;
+    if (events.count("printer-state-changed") &&
+        (e == "printer-stopped" || e == "printer-restarted" || e == "printer-shutdown"))
+        return true;
+
+    return false;
+}
+
+bool PrinterWatchFilter::IsKnownEvent(const std::string &event)
+{
+    for (const char *known : kKnownEvents)
+        if (event == known)
+            return true;
+    return false;
+}
+
+/* =========================================================
+   PrinterWatcher
+========================================================= */
+
+PrinterWatcher::PrinterWatcher(PrinterService &service)
+    : service(service)
+{
+}
+
+PrinterWatcher::~PrinterWatcher()
+{
+    Stop();
+}
+
+std::set<std::string> PrinterWatcher::WantedLocked() const
+{
+    std::set<std::string> wanted(std::begin(kRegistryEvents), std::end(kRegistryEvents));
+    for (auto &kv : listeners)
+        wanted.insert(kv.second.filter.events.begin(), kv.second.filter.events.end());
+    return wanted;
+}
+
+uint64_t PrinterWatcher::Add(const PrinterWatchFilter &filter, std::shared_ptr<PrinterWatchListener> listener)
+{
+    std::lock_guard<std::mutex> lock(mu);
+    if (stopping)
+        return 0;
+
+    uint64_t id = nextId++;
+    listeners[id] = Entry{ filter, std::move(listener) };
+
+    if (!thread.joinable())
+        thread = std::thread(&PrinterWatcher::Loop, this);
+
+    // Resubscribe with the new events
+    if (source && !std::includes(sourceEvents.begin(), sourceEvents.end(),
+                                 filter.events.begin(), filter.events.end()))
+        source->Interrupt();
+
+    cv.notify_all();
+    return id;
+}
+
+void PrinterWatcher::Remove(uint64_t id)
+{
+    std::shared_ptr<PrinterWatchListener> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = listeners.find(id);
+        if (it == listeners.end())
+            return;
+
+        dropped = std::move(it->second.listener);
+        listeners.erase(it);
+
+        // Nobody left: close the subscription
+        if (listeners.empty() && source)
+            source->Interrupt();
+    }
+}
+
+void PrinterWatcher::Stop()
+{
+    std::map<uint64_t, Entry> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+        if (source)
+            source->Interrupt();
+        dropped.swap(listeners);
+    }
+    cv.notify_all();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+void PrinterWatcher::Dispatch(const std::vector<PrinterEventNative> &events)
+{
+    std::vector<std::pair<std::shared_ptr<PrinterWatchListener>, std::vector<PrinterEventNative>>> deliveries;
+    bool printersChanged = false;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto &kv : listeners)
+        {
+            std::vector<PrinterEventNative> matched;
+            for (auto &e : events)
+                if (kv.second.filter.Matches(e))
+                    matched.push_back(e);
+
+            if (!matched.empty())
+                deliveries.emplace_back(kv.second.listener, std::move(matched));
+        }
+    }
+
+    for (auto &e : events)
+        for (const char *registryEvent : kRegistryEvents)
+            printersChanged = printersChanged || e.event == registryEvent;
+
+    if (printersChanged)
+        service.Registry().Invalidate();
+
+    for (auto &d : deliveries)
+        d.first->OnEvents(d.second);
+}
+
+void PrinterWatcher::ReportError(const std::string &message)
+{
+    std::vector<std::shared_ptr<PrinterWatchListener>> targets;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto &kv : listeners)
+            targets.push_back(kv.second.listener);
+    }
+
+    for (auto &l : targets)
+        l->OnError(message);
+}
+
+void PrinterWatcher::Loop()
+{
+    std::unique_lock<std::mutex> lock(mu);
+    auto retry = kRetryMin;
+    bool missed = false; // printer events may have been lost
+
+    while (!stopping)
+    {
+        if (listeners.empty())
+        {
+            cv.wait(lock, [this]() { return stopping || !listeners.empty(); });
+            continue;
+        }
+
+        std::set<std::string> wanted = WantedLocked();
+        lock.unlock();
+        std::unique_ptr<PrinterEventSourceNative> opened = service.Backend().OpenEventSource(wanted);
+        lock.lock();
+
+        if (!opened)
+        {
+            missed = true;
+            lock.unlock();
+            ReportError("Could not subscribe to printer events");
+            lock.lock();
+
+            cv.wait_for(lock, retry, [this]() { return stopping; });
+            retry = std::min(retry * 2, kRetryMax);
+            continue;
+        }
+
+        source = opened.get();
+        sourceEvents = wanted;
+
+        if (missed)
+        {
+            missed = false;
+            service.Registry().Invalidate();
+        }
+
+        auto covered = [this]()
+        {
+            std::set<std::string> now = WantedLocked();
+            return std::includes(sourceEvents.begin(), sourceEvents.end(), now.begin(), now.end());
+        };
+
+        // Until Add / Remove / Stop interrupt it or the subscription is lost;
+        // listeners added while it was being created may need more events.
+        bool ok = true;
+        while (ok && !stopping && !listeners.empty() && covered())
+        {
+            lock.unlock();
+            std::vector<PrinterEventNative> events;
+            ok = opened->Next(events);
+            if (!events.empty())
+                Dispatch(events);
+            lock.lock();
+
+            if (ok)
+                retry = kRetryMin;
+        }
+
+        // Cancelling the subscription talks to the server: not under the lock
+        source = nullptr;
+        lock.unlock();
+        opened.reset();
+        lock.lock();
+
+        if (!ok)
+            missed = true;
+
+        if (!ok && !stopping && !listeners.empty() && covered())
+        {
+            lock.unlock();
+            ReportError("Printer event subscription lost");
+            lock.lock();
+
+            cv.wait_for(lock, retry, [this]() { return stopping; });
+            retry = std::min(retry * 2, kRetryMax);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#ifndef PRINTER_WATCHER_H
+#define PRINTER_WATCHER_H
+
+#include "printer_interface.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PrinterService;
+
+class PrinterWatchListener
+{
+public:
+    virtual ~PrinterWatchListener() = default;
+
+    // On the watcher thread, with the events that passed the filter
+    virtual void OnEvents(const std::vector<PrinterEventNative> &events) = 0;
+
+    // The subscription could not be created or was lost; the watcher
+    // keeps retrying.
+    virtual void OnError(const std::string &message) = 0;
+};
+
+struct PrinterWatchFilter
+{
+    std::set<std::string> printers; // empty = every printer
+    std::set<std::string> events;   // IPP event keywords, see IsKnownEvent
+
+    // job-state-changed also matches job-created / -completed / -stopped,
+    // printer-state-changed the printer-stopped family.
+    bool Matches(const PrinterEventNative &event) const;
+
+    static bool IsKnownEvent(const std::string &event);
+};
+
+/*
+  Shares one backend event subscription (PrinterInterface::
+  OpenEventSource) between every listener, on one thread.
+
+  The subscription covers the union of the listeners' events plus
+  printer-added / -deleted / -modified, which invalidate the printer
+  registry (the service keeps a listener of its own for them, so the
+  subscription stays open while it runs). It is recreated when a
+  listener needs an event it lacks and closed when the last listener
+  goes; a lost subscription is recreated with backoff, and the registry
+  is invalidated once it is back since changes in between were missed.
+  The thread starts on first use.
+*/
+class PrinterWatcher
+{
+public:
+    static constexpr std::chrono::milliseconds kRetryMin{500};
+    static constexpr std::chrono::milliseconds kRetryMax{30000};
+
+    explicit PrinterWatcher(PrinterService &service);
+    ~PrinterWatcher();
+
+    PrinterWatcher(const PrinterWatcher &) = delete;
+    PrinterWatcher &operator=(const PrinterWatcher &) = delete;
+
+    // Returns an id for Remove
+    uint64_t Add(const PrinterWatchFilter &filter, std::shared_ptr<PrinterWatchListener> listener);
+
+    // The listener is released here or, when an OnEvents call for it is
+    // in progress, right after that call.
+    void Remove(uint64_t id);
+
+    // Drops every listener and ends the thread; before the backend shuts down.
+    void Stop();
+
+private:
+    struct Entry
+    {
+        PrinterWatchFilter filter;
+        std::shared_ptr<PrinterWatchListener> listener;
+    };
+
+    void Loop();
+    std::set<std::string> WantedLocked() const;
+    void Dispatch(const std::vector<PrinterEventNative> &events);
+    void ReportError(const std::string &message);
+
+    PrinterService &service;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::map<uint64_t, Entry> listeners;
+    uint64_t nextId = 1;
+
+    std::thread thread;
+    bool stopping = false;
+    PrinterEventSourceNative *source = nullptr; // open subscription, owned by the thread
+    std::set<std::string> sourceEvents;
+};
+
+#endif
@@ -65,7 +65,7 @@ std::vector<std::string> WindowsPrinter::MapJobStatus(DWORD status)
     if (status & JOB_STATUS_SPOOLING) out.push_back("PENDING");
     if (status & JOB_STATUS_DELETING) out.push_back("CANCELLED");
     if (status & JOB_STATUS_DELETED) out.push_back("CANCELLED");
-    if (status & JOB_STATUS_ERROR) out.push_back("ABORTED");
+    if (status & JOB_STATUS_ERROR) out.push_back("STOPPED"); // until restarted or deleted
     if (status & JOB_STATUS_OFFLINE) out.push_back("PENDING");
     if (status & JOB_STATUS_PAPEROUT) out.push_back("PENDING");
     if (status & JOB_STATUS_PRINTED) out.push_back("PRINTED");
@@ -209,13 +209,35 @@ std::vector<std::string> WindowsPrinter::GetSupportedPrintFormats()
     return { "RAW", "TEXT", "COMMAND" };
 }
 
+// Maps IPP job-priority (1..100) onto the spooler's MIN_PRIORITY..MAX_PRIORITY
+static void SetSpoolerPriority(HANDLE hPrinter, DWORD jobId, int priority)
+{
+    DWORD needed = 0;
+    GetJobW(hPrinter, jobId, 1, NULL, 0, &needed);
+    if (needed == 0)
+        return;
+
+    std::vector<BYTE> buf(needed);
+    if (!GetJobW(hPrinter, jobId, 1, buf.data(), needed, &needed))
+        return;
+
+    JOB_INFO_1W *info = (JOB_INFO_1W *)buf.data();
+    info->Position = JOB_POSITION_UNSPECIFIED;
+    info->Priority = MIN_PRIORITY + (DWORD)((priority - 1) * (MAX_PRIORITY - MIN_PRIORITY) / 99);
+    SetJobW(hPrinter, jobId, 1, (LPBYTE)info, 0);
+}
+
 int WindowsPrinter::PrintDirect(const std::string &printerName,
-                                const std::vector<uint8_t> &data,
+                                ByteSpan data,
                                 const std::string &type,
-                                const StringMap &options)
+                                const StringMap &options,
+                                const PrintControl &control)
 {
     (void)options;
 
+    if (control.Cancelled())
+        return 0;
+
     HANDLE hPrinter = NULL;
     std::wstring wPrinterName = Utf8ToWide(printerName);
 
@@ -228,8 +250,8 @@ int WindowsPrinter::PrintDirect(const std::string &printerName,
     std::wstring wDataType = Utf8ToWide("RAW");
 
     DOC_INFO_1W docInfo;
-    wchar_t docName[] = L"Node Print Job";
-    docInfo.pDocName = docName;
+    std::wstring docName = Utf8ToWide(control.jobName.empty() ? "Node Print Job" : control.jobName);
+    docInfo.pDocName = (LPWSTR)docName.c_str();
     docInfo.pOutputFile = NULL;
     docInfo.pDatatype = (LPWSTR)wDataType.c_str();
 
@@ -240,6 +262,9 @@ int WindowsPrinter::PrintDirect(const std::string &printerName,
         return 0;
     }
 
+    if (control.priority > 0)
+        SetSpoolerPriority(hPrinter, jobId, control.priority);
+
     if (!StartPagePrinter(hPrinter))
     {
         EndDocPrinter(hPrinter);
@@ -247,21 +272,41 @@ int WindowsPrinter::PrintDirect(const std::string &printerName,
         return 0;
     }
 
-    DWORD bytesWritten = 0;
-    BOOL ok = WritePrinter(hPrinter, (LPVOID)data.data(), (DWORD)data.size(), &bytesWritten);
+    // One WritePrinter, or 1 MiB chunks when the caller follows progress
+    // or may cancel
+    const bool chunked = control.onProgress || control.cancelled;
+    const size_t step = chunked || data.size == 0 ? 1024 * 1024 : data.size;
+    BOOL ok = TRUE;
+    for (size_t off = 0; off < data.size && ok; off += step)
+    {
+        if (control.Cancelled())
+        {
+            SetJobW(hPrinter, jobId, 0, NULL, JOB_CONTROL_DELETE);
+            ok = FALSE;
+            break;
+        }
+
+        DWORD n = (DWORD)(data.size - off < step ? data.size - off : step);
+        DWORD bytesWritten = 0;
+        ok = WritePrinter(hPrinter, (LPVOID)(data.data + off), n, &bytesWritten) && bytesWritten == n;
+
+        if (ok && control.onProgress)
+            control.onProgress(off + n, data.size);
+    }
 
     EndPagePrinter(hPrinter);
     EndDocPrinter(hPrinter);
     ClosePrinter(hPrinter);
 
-    if (!ok || bytesWritten != (DWORD)data.size())
+    if (!ok)
         return 0;
 
     return (int)jobId;
 }
 
 int WindowsPrinter::PrintFile(const std::string &printerName,
-                              const std::string &filename)
+                              const std::string &filename,
+                              const PrintControl &control)
 {
     std::vector<uint8_t> data;
     if (!ReadAllBytes(filename, data))
@@ -269,7 +314,7 @@ int WindowsPrinter::PrintFile(const std::string &printerName,
 
     // PrintFile typing does not include type, so we treat it as RAW bytes.
     StringMap emptyOpts;
-    return PrintDirect(printerName, data, "RAW", emptyOpts);
+    return PrintDirect(printerName, ByteSpan{ data.data(), data.size() }, "RAW", emptyOpts, control);
 }
 
 JobDetailsNative WindowsPrinter::GetJob(const std::string &printerName, int jobId)
@@ -281,12 +326,18 @@ JobDetailsNative WindowsPrinter::GetJob(const std::string &printerName, int jobI
     HANDLE hPrinter = NULL;
     std::wstring wPrinterName = Utf8ToWide(printerName);
     if (!OpenPrinterW((LPWSTR)wPrinterName.c_str(), &hPrinter, NULL))
+    {
+        LastQueryFailed() = true;
         return j;
+    }
 
+    // An unknown job id fails with ERROR_INVALID_PARAMETER
     DWORD needed = 0;
     GetJobW(hPrinter, (DWORD)jobId, 2, NULL, 0, &needed);
     if (needed == 0)
     {
+        if (GetLastError() != ERROR_INVALID_PARAMETER)
+            LastQueryFailed() = true;
         ClosePrinter(hPrinter);
         return j;
     }
@@ -294,12 +345,23 @@ JobDetailsNative WindowsPrinter::GetJob(const std::string &printerName, int jobI
     std::vector<BYTE> buffer(needed);
     if (!GetJobW(hPrinter, (DWORD)jobId, 2, buffer.data(), needed, &needed))
     {
+        if (GetLastError() != ERROR_INVALID_PARAMETER)
+            LastQueryFailed() = true;
         ClosePrinter(hPrinter);
         return j;
     }
 
-    JOB_INFO_2W *ji = (JOB_INFO_2W *)buffer.data();
+    j = JobFromInfo((JOB_INFO_2W *)buffer.data(), printerName);
 
+    ClosePrinter(hPrinter);
+    return j;
+}
+
+JobDetailsNative WindowsPrinter::JobFromInfo(const JOB_INFO_2W *ji, const std::string &printerName)
+{
+    JobDetailsNative j;
+    j.id = (int)ji->JobId;
+    j.printerName = printerName;
     j.name = ji->pDocument ? WideToUtf8(ji->pDocument) : "";
     j.user = ji->pUserName ? WideToUtf8(ji->pUserName) : "";
     j.format = "RAW";
@@ -311,11 +373,67 @@ JobDetailsNative WindowsPrinter::GetJob(const std::string &printerName, int jobI
     j.creationTime = SystemTimeToTimeT(ji->Submitted);
     j.processingTime = j.creationTime;
     j.completedTime = 0;
-
-    ClosePrinter(hPrinter);
     return j;
 }
 
+std::vector<JobDetailsNative> WindowsPrinter::GetJobs(const std::string &printerName, const JobQueryNative &query)
+{
+    std::vector<JobDetailsNative> out;
+
+    // The spooler lists one printer at a time
+    if (printerName.empty())
+    {
+        for (auto &p : GetPrinters())
+        {
+            auto jobs = GetJobs(p.name, query);
+            out.insert(out.end(), jobs.begin(), jobs.end());
+        }
+    }
+    else
+    {
+        HANDLE hPrinter = NULL;
+        std::wstring wPrinterName = Utf8ToWide(printerName);
+        if (!OpenPrinterW((LPWSTR)wPrinterName.c_str(), &hPrinter, NULL))
+        {
+            LastQueryFailed() = true;
+            return out;
+        }
+
+        DWORD needed = 0, returned = 0;
+        EnumJobsW(hPrinter, 0, 0xFFFFFFFF, 2, NULL, 0, &needed, &returned);
+
+        std::vector<BYTE> buffer(needed);
+        bool listed = needed > 0 &&
+                      EnumJobsW(hPrinter, 0, 0xFFFFFFFF, 2, buffer.data(), needed, &needed, &returned);
+        if (needed > 0 && !listed)
+            LastQueryFailed() = true;
+        if (listed)
+        {
+            JOB_INFO_2W *jobs = (JOB_INFO_2W *)buffer.data();
+            for (DWORD i = 0; i < returned; i++)
+            {
+                // Only retained jobs ("keep printed documents") are completed
+                bool completed = (jobs[i].Status & (JOB_STATUS_PRINTED | JOB_STATUS_DELETED)) != 0;
+                if ((query.which == JobWhich::Active && completed) ||
+                    (query.which == JobWhich::Completed && !completed))
+                    continue;
+
+                JobDetailsNative j = JobFromInfo(&jobs[i], printerName);
+                if (query.Matches(j))
+                    out.push_back(std::move(j));
+            }
+        }
+
+        ClosePrinter(hPrinter);
+    }
+
+    std::sort(out.begin(), out.end(),
+              [](const JobDetailsNative &a, const JobDetailsNative &b) { return a.id < b.id; });
+    if (query.limit > 0 && out.size() > (size_t)query.limit)
+        out.resize((size_t)query.limit);
+    return out;
+}
+
 void WindowsPrinter::SetJob(const std::string &printerName, int jobId, const std::string &command)
 {
     HANDLE hPrinter = NULL;
@@ -14,6 +14,8 @@ async function run() {
     return;
   }
 
+  printer.refreshPrinters();
+
   const defaultPrinter = printer.getDefaultPrinterName();
   console.log("Default printer:", defaultPrinter);
 
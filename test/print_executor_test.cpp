@@ -0,0 +1,369 @@
+/*
+  PrintExecutor scheduling and admission. The executor has no N-API or
+  CUPS dependency, so this builds on its own:
+
+    g++ -std=c++17 -O1 -g -pthread -Isrc test/print_executor_test.cpp \
+        src/print_executor.cpp -o print_executor_test
+    ./print_executor_test
+
+  (npm run test:executor does both). Adding -fsanitize=thread checks the
+  locking as well. Timing-dependent cases leave wide margins around
+  kAgingStep.
+*/
+
+#include "print_executor.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,     \
+                         __LINE__, #cond);                                  \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+// Holds a task in Run until opened, keeping its printer busy
+class Gate
+{
+public:
+    void Open()
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        open = true;
+        cv.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        cv.wait(lock, [this]() { return open; });
+    }
+
+private:
+    std::mutex mu;
+    std::condition_variable cv;
+    bool open = false;
+};
+
+// What the tasks did, in the order they did it
+class Log
+{
+public:
+    void Add(const std::string &entry)
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        entries.push_back(entry);
+    }
+
+    std::vector<std::string> Entries()
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        return entries;
+    }
+
+private:
+    std::mutex mu;
+    std::vector<std::string> entries;
+};
+
+class RecordingTask : public PrintTask
+{
+public:
+    RecordingTask(Log &log, std::string name, Gate *gate = nullptr)
+        : log(log), name(std::move(name)), gate(gate) {}
+
+    void Run() override
+    {
+        if (gate)
+            gate->Wait();
+        log.Add(name);
+    }
+
+    void Expire() override { log.Add("expired:" + name); }
+
+private:
+    Log &log;
+    std::string name;
+    Gate *gate;
+};
+
+static std::unique_ptr<PrintTask> Task(Log &log, const std::string &name, Gate *gate = nullptr)
+{
+    return std::unique_ptr<PrintTask>(new RecordingTask(log, name, gate));
+}
+
+static PrintTaskOptions Options(int priority = PrintTaskOptions::kDefaultPriority,
+                                size_t bytes = 0,
+                                bool waitIfFull = false)
+{
+    PrintTaskOptions o;
+    o.priority = priority;
+    o.bytes = bytes;
+    o.waitIfFull = waitIfFull;
+    return o;
+}
+
+// Polls until nothing is queued, parked or running
+static bool WaitIdle(PrintExecutor &executor, milliseconds timeout = milliseconds(5000))
+{
+    auto until = Clock::now() + timeout;
+    while (Clock::now() < until)
+    {
+        PrintQueueStatsNative s = executor.Stats();
+        if (s.jobs == 0 && s.running == 0 && s.waiting == 0)
+            return true;
+        std::this_thread::sleep_for(milliseconds(5));
+    }
+    return false;
+}
+
+// Polls until the first task on a printer has been picked up, so the
+// ones submitted after it queue behind a running task
+static void WaitRunning(PrintExecutor &executor, size_t count)
+{
+    auto until = Clock::now() + milliseconds(5000);
+    while (executor.Stats().running < count && Clock::now() < until)
+        std::this_thread::sleep_for(milliseconds(1));
+}
+
+static bool SameOrder(const std::vector<std::string> &got, const std::vector<std::string> &want)
+{
+    if (got == want)
+        return true;
+
+    std::fprintf(stderr, "  got:");
+    for (auto &e : got)
+        std::fprintf(stderr, " %s", e.c_str());
+    std::fprintf(stderr, "\n  want:");
+    for (auto &e : want)
+        std::fprintf(stderr, " %s", e.c_str());
+    std::fprintf(stderr, "\n");
+    return false;
+}
+
+/* =========================================================
+   Cases
+========================================================= */
+
+// Equal priorities on one printer run in submission order, one at a time
+static void TestFifoWithinPrinter()
+{
+    PrintExecutor executor(4);
+    Log log;
+    Gate gate;
+
+    CHECK(executor.Submit("A", Task(log, "hold", &gate)) == PrintExecutor::Admission::Queued);
+    WaitRunning(executor, 1);
+
+    for (int i = 1; i <= 5; i++)
+        CHECK(executor.Submit("A", Task(log, std::to_string(i))) == PrintExecutor::Admission::Queued);
+
+    // Free threads must not start a second task on the busy printer
+    std::this_thread::sleep_for(milliseconds(20));
+    CHECK(executor.Stats().running == 1);
+
+    gate.Open();
+    CHECK(WaitIdle(executor));
+    CHECK(SameOrder(log.Entries(), { "hold", "1", "2", "3", "4", "5" }));
+}
+
+// A much higher priority overtakes a fresh bulk job; a bulk job that has
+// waited long enough overtakes a slightly higher one
+static void TestPriorityAgingCrossover()
+{
+    {
+        PrintExecutor executor(1);
+        Log log;
+        Gate gate;
+
+        executor.Submit("A", Task(log, "hold", &gate));
+        WaitRunning(executor, 1);
+        executor.Submit("A", Task(log, "bulk"), Options(1));
+        executor.Submit("A", Task(log, "urgent"), Options(20));
+
+        gate.Open();
+        CHECK(WaitIdle(executor));
+        CHECK(SameOrder(log.Entries(), { "hold", "urgent", "bulk" }));
+    }
+
+    {
+        PrintExecutor executor(1);
+        Log log;
+        Gate gate;
+
+        executor.Submit("A", Task(log, "hold", &gate));
+        WaitRunning(executor, 1);
+        executor.Submit("A", Task(log, "bulk"), Options(1));
+
+        // Eight aging steps lift the bulk job to about 9, past 3
+        std::this_thread::sleep_for(PrintExecutor::kAgingStep * 8);
+        executor.Submit("A", Task(log, "urgent"), Options(3));
+
+        gate.Open();
+        CHECK(WaitIdle(executor));
+        CHECK(SameOrder(log.Entries(), { "hold", "bulk", "urgent" }));
+    }
+}
+
+// A parked task whose deadline passes is expired, never run, and frees
+// its place
+static void TestParkedTaskExpires()
+{
+    PrintExecutor executor(2);
+    Log log;
+    Gate gate;
+
+    PrintQueueLimits limits;
+    limits.maxJobs = 1;
+    executor.SetLimits(limits);
+
+    CHECK(executor.Submit("A", Task(log, "hold", &gate)) == PrintExecutor::Admission::Queued);
+    WaitRunning(executor, 1);
+
+    PrintTaskOptions late = Options(PrintTaskOptions::kDefaultPriority, 0, true);
+    late.deadline = Clock::now() + milliseconds(50);
+    CHECK(executor.Submit("A", Task(log, "late"), late) == PrintExecutor::Admission::Waiting);
+    CHECK(executor.Submit("B", Task(log, "other"), Options(50, 0, true)) == PrintExecutor::Admission::Waiting);
+
+    // The idle worker expires it while "hold" still runs
+    std::this_thread::sleep_for(milliseconds(300));
+    PrintQueueStatsNative s = executor.Stats();
+    CHECK(s.expired == 1);
+    CHECK(s.waiting == 1);
+    CHECK(s.jobs == 1);
+
+    gate.Open();
+    CHECK(WaitIdle(executor));
+    CHECK(SameOrder(log.Entries(), { "expired:late", "hold", "other" }));
+}
+
+// Parked tasks are admitted in submission order per printer, whatever
+// their priority; a task that would fit still parks behind them, and
+// other printers are not held up
+static void TestParkedOrderPerPrinter()
+{
+    PrintExecutor executor(2);
+    Log log;
+    Gate gate;
+
+    PrintQueueLimits limits;
+    limits.maxBytesPerPrinter = 100;
+    executor.SetLimits(limits);
+
+    CHECK(executor.Submit("A", Task(log, "hold", &gate), Options(50, 10)) == PrintExecutor::Admission::Queued);
+    WaitRunning(executor, 1);
+
+    CHECK(executor.Submit("A", Task(log, "big"), Options(1, 200, true)) == PrintExecutor::Admission::Waiting);
+    CHECK(executor.Submit("A", Task(log, "small"), Options(100, 10, true)) == PrintExecutor::Admission::Waiting);
+    CHECK(executor.Submit("A", Task(log, "rejected"), Options(100, 10, false)) == PrintExecutor::Admission::Full);
+    CHECK(executor.Submit("B", Task(log, "B"), Options(50, 10)) == PrintExecutor::Admission::Queued);
+
+    // B runs on the other thread while A is blocked
+    auto until = Clock::now() + milliseconds(5000);
+    while (log.Entries().empty() && Clock::now() < until)
+        std::this_thread::sleep_for(milliseconds(1));
+    CHECK(SameOrder(log.Entries(), { "B" }));
+    CHECK(executor.Stats().waiting == 2);
+    CHECK(executor.Stats().rejected == 1);
+
+    gate.Open();
+    CHECK(WaitIdle(executor));
+    CHECK(SameOrder(log.Entries(), { "B", "hold", "big", "small" }));
+}
+
+// Jobs counted through Charge (a coalesced document riding on an
+// admitted task) hold their place until discharged, then every counter
+// is back to zero and the printer is forgotten
+static void TestChargeDischarge()
+{
+    PrintExecutor executor(1);
+    Log log;
+    Gate gate;
+
+    PrintQueueLimits limits;
+    limits.maxJobsPerPrinter = 3;
+    executor.SetLimits(limits);
+
+    CHECK(!executor.Charge("A", 5)); // nothing admitted there
+
+    executor.Submit("A", Task(log, "hold", &gate), Options(50, 10));
+    WaitRunning(executor, 1);
+
+    CHECK(executor.Charge("A", 20));
+    CHECK(executor.Charge("A", 30));
+    CHECK(!executor.Charge("A", 40)); // per-printer limit reached
+
+    PrintQueueStatsNative s = executor.Stats();
+    CHECK(s.jobs == 3);
+    CHECK(s.bytes == 60);
+    CHECK(s.printers.size() == 1 && s.printers[0].jobs == 3);
+
+    // Charged jobs count against the limit like queued ones
+    CHECK(executor.Submit("A", Task(log, "next"), Options(50, 1, true)) == PrintExecutor::Admission::Waiting);
+    CHECK(!executor.Charge("A", 1)); // a job is parked on the printer
+
+    // "next" is admitted once "hold" finishes; the charges outlive both
+    gate.Open();
+    auto until = Clock::now() + milliseconds(5000);
+    while (log.Entries().size() < 2 && Clock::now() < until)
+        std::this_thread::sleep_for(milliseconds(1));
+    std::this_thread::sleep_for(milliseconds(20));
+    s = executor.Stats();
+    CHECK(s.jobs == 2);
+    CHECK(s.bytes == 50);
+    CHECK(s.waiting == 0);
+
+    executor.Discharge("A", 2, 50);
+    CHECK(WaitIdle(executor));
+
+    s = executor.Stats();
+    CHECK(s.jobs == 0);
+    CHECK(s.bytes == 0);
+    CHECK(s.running == 0);
+    CHECK(s.waiting == 0);
+    CHECK(s.printers.empty());
+    CHECK(SameOrder(log.Entries(), { "hold", "next" }));
+}
+
+int main()
+{
+    struct Case
+    {
+        const char *name;
+        void (*fn)();
+    };
+
+    const Case cases[] = {
+        { "fifo within printer", TestFifoWithinPrinter },
+        { "priority vs aging", TestPriorityAgingCrossover },
+        { "parked task expires", TestParkedTaskExpires },
+        { "parked order per printer", TestParkedOrderPerPrinter },
+        { "charge / discharge", TestChargeDischarge },
+    };
+
+    for (auto &c : cases)
+    {
+        int before = failures;
+        c.fn();
+        std::printf("%-28s %s\n", c.name, failures == before ? "ok" : "FAILED");
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}